@@ -31,11 +31,11 @@ namespace avl_impl_{
 						p(p){}
 
 		constexpr Node(Node &&other) :
-					key	(std::move(key		)),
-					height	(std::move(height	)),
-					l	(std::move(l		)),
-					r	(std::move(r		)),
-					p	(std::move(p		)){}
+					key	(std::move(other.key	)),
+					height	(std::move(other.height	)),
+					l	(std::move(other.l	)),
+					r	(std::move(other.r	)),
+					p	(std::move(other.p	)){}
 
 		constexpr Node &operator =(Node &&other){
 			using std::swap;
@@ -98,6 +98,21 @@ namespace avl_impl_{
 		delete node;
 	}
 
+	template<typename T>
+	Node<T> *clone(const Node<T> *node, Node<T> *parent){
+		// same shape, keys are copied, no comparisons, O(n)
+		if (!node)
+			return nullptr;
+
+		auto *copy = new Node<T>(node->key, parent);
+
+		copy->height	= node->height;
+		copy->l		= clone(node->l, copy);
+		copy->r		= clone(node->r, copy);
+
+		return copy;
+	}
+
 	// ----------------------------------------
 
 	template<bool checkNode, typename T>
@@ -465,6 +480,24 @@ public:
 		avl_impl_::deallocate(root);
 	}
 
+	AVLTree(AVLTree const &) = delete;
+	AVLTree &operator =(AVLTree const &) = delete;
+
+	AVLTree(AVLTree &&other) : root(other.root){
+		other.root = nullptr;
+	}
+
+	AVLTree &operator =(AVLTree &&other){
+		std::swap(root, other.root);
+		return *this;
+	}
+
+	AVLTree clone() const{
+		AVLTree tree;
+		tree.root = avl_impl_::clone(root, static_cast<Node *>(nullptr));
+		return tree;
+	}
+
 	void clear(){
 		avl_impl_::deallocate(root);
 		root = nullptr;
@@ -501,6 +534,10 @@ public:
 	}
 
 	iterator begin() const{
+		// minValueNode() needs a node
+		if (!root)
+			return end();
+
 		return avl_impl_::minValueNode(root);
 	}
 
@@ -630,6 +667,21 @@ int main(){
 
 		assert(*tree.find(97, std::false_type{}) == 98);
 		assert(tree.find(99, std::false_type{}) == std::end(tree));
+
+		printf("--------\n");
+
+		auto copy = tree.clone();
+
+		insert(copy, 99);
+		u = copy.erase(10); assert(u);
+
+		assert(tree.find(99, std::true_type{}) == std::end(tree));
+		assert(tree.find(10, std::true_type{}) != std::end(tree));
+
+		AVLTree<int, true> moved = std::move(copy);
+
+		assert(copy.begin() == std::end(copy));
+		assert(*moved.begin() == 20);
 	}
 }
 
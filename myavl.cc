@@ -1,48 +1,282 @@
 #include <cstdint>
 #include <cassert>
-#include <algorithm>	// max, swap
+#include <array>
+#include <algorithm>	// max, swap, min, adjacent_find
+#include <iterator>	// distance
+#include <numeric>	// accumulate
+#include <type_traits>
+#include <limits>
+#include <vector>
+#include <memory>	// allocator
+#include <functional>	// less, hash
+#include <utility>	// as_const
+#include <string>
+#include <string_view>
+#include <cstring>	// memcpy
+#include <sstream>
+#include <fstream>
+#include <cstdio>	// rename
+#include <cerrno>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <fcntl.h>	// open
+#include <unistd.h>	// write, fsync, ftruncate
 
 #include <iostream>
 
 
 
+// C++20 allows new / delete in constant expressions,
+// then AVLTree can be built at compile time.
+#if __cpp_constexpr_dynamic_alloc >= 201907L
+	#define AVL_CONSTEXPR_20 constexpr
+#else
+	#define AVL_CONSTEXPR_20
+#endif
+
+
+
 namespace avl_impl_{
 
 	using balance_t        = int8_t;
 
 
 
+	constexpr bool isConstantEvaluated_(){
+	#if defined(__GNUC__)
+		return __builtin_is_constant_evaluated();
+	#else
+		return false;
+	#endif
+	}
+
+#ifdef AVL_STATS
+	// rebalance counters, for ./myavl bench wavl
+
+	struct Stats{
+		size_t rotations	= 0;
+		size_t writes		= 0;	// balance / rank updates
+	};
+
+	inline Stats stats;
+
+	#define AVL_STAT_(x, n)	(void) (avl_impl_::isConstantEvaluated_() || (avl_impl_::stats.x += n))
+#else
+	#define AVL_STAT_(x, n)	(void) 0
+#endif
+
+
+
+	/*
+	 * Balance policies of AVLTree.
+	 *
+	 * AVLBalance	- balance = height(r) - height(l).
+	 *
+	 * WAVLBalance	- weak AVL, balance is the rank.
+	 *		  leaf has rank 0, nullptr has rank -1,
+	 *		  rank differences are 1 or 2 and leaves are 1,1.
+	 *		  without erase the tree is the same as AVL,
+	 *		  erase does at most 2 rotations and O(1) amortized rank updates,
+	 *		  the height stays under 2 log n.
+	 */
+
+	struct AVLBalance{
+		constexpr static bool WEAK = false;
+	};
+
+	struct WAVLBalance{
+		constexpr static bool WEAK = true;
+	};
+
+
+
+	// opt in, AVLTree<PrefixString> caches the first 8 bytes of the key in the node,
+	// big endian, so most comparisons on the descent do not touch the string buffer.
+	// it pays off when the keys differ early, the node grows by 8 bytes,
+	// Node<std::string> from 64 to 72, one cache line to two.
+	// keys with the same first 8 bytes, such as URLs after "https://",
+	// always tie on the prefix, there it is slower than std::string.
+
+	template<typename S>
+	struct Prefixed : S{
+		using S::S;
+
+		constexpr Prefixed(S s) : S(std::move(s)){}
+	};
+
+	using PrefixString	= Prefixed<std::string>;
+	using PrefixStringView	= Prefixed<std::string_view>;
+
+	template<typename T>
+	constexpr bool hasPrefix_ = false;
+
+	template<typename S>
+	constexpr bool hasPrefix_<Prefixed<S> > = true;
+
+	// keys hashed and looked up as std::string_view
+	template<typename T>
+	constexpr bool isStringKey_ = hasPrefix_<T> || std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>;
+
+	struct NoPrefix_{};
+
+	template<typename T>
+	using prefix_t = std::conditional_t<hasPrefix_<T>, uint64_t, NoPrefix_>;
+
+	constexpr uint64_t keyPrefix_(std::string_view const s){
+		// zero padded, bytes compare as unsigned char, same as std::string.
+
+		uint64_t p = 0;
+
+	#if defined(__GNUC__)
+		if (s.size() >= sizeof p && !isConstantEvaluated_()){
+			// one load and bswap
+			std::memcpy(&p, s.data(), sizeof p);
+
+		#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+			p = __builtin_bswap64(p);
+		#endif
+
+			return p;
+		}
+	#endif
+
+		for(size_t i = 0; i < sizeof p; ++i)
+			p = p << 8 | (i < s.size() ? uint8_t(s[i]) : 0);
+
+		return p;
+	}
+
+	template<typename T, typename UT>
+	constexpr auto keyPrefixOf_(UT const &key){
+		if constexpr(hasPrefix_<T> && std::is_convertible_v<UT const &, std::string_view>)
+			return keyPrefix_(key);
+		else
+			return NoPrefix_{};
+	}
+
+	// arithmetic keys go down without data dependent branches,
+	// see AVLTree::find() and AVLTree::insert().
+
+	template<typename T, typename UT>
+	constexpr bool isBranchless_ = std::is_arithmetic_v<T> && std::is_arithmetic_v<UT>;
+
+	template<typename UT, typename P, typename N>
+	constexpr int compare_(UT const &key, P const prefix, const N *node){
+		// the prefix decides, unless it is a tie.
+
+		if constexpr(std::is_same_v<P, uint64_t>)
+			if (prefix != node->prefix)
+				return prefix < node->prefix ? -1 : +1;
+
+		if (key < node->data)
+			return -1;
+
+		if (key > node->data)
+			return +1;
+
+		return 0;
+	}
+
+
+
+	// AVLMultiset keeps one node per key, with the number of copies.
+	// count is not part of the key, so it can change while the node is linked.
+
+	template<typename T>
+	struct Counted{
+		T		key;
+		mutable size_t	count = 1;
+
+		constexpr Counted(T key) : key(std::move(key)){}
+	};
+
+	template<typename T>
+	constexpr bool isCounted_ = false;
+
+	template<typename T>
+	constexpr bool isCounted_<Counted<T> > = true;
+
+	// key wrappers, Counted, Merkle and Slotted, compare by the key only.
+
+	template<typename T>
+	constexpr bool isKeyWrapper_ = isCounted_<T>;
+
+	template<typename T>
+	constexpr const auto &unwrapKey_(T const &x){
+		if constexpr(isKeyWrapper_<T>)
+			return x.key;
+		else
+			return x;
+	}
+
+	template<typename A, typename B, typename = std::enable_if_t<isKeyWrapper_<A> || isKeyWrapper_<B> > >
+	constexpr bool operator <(A const &a, B const &b){
+		return unwrapKey_(a) < unwrapKey_(b);
+	}
+
+	template<typename A, typename B, typename = std::enable_if_t<isKeyWrapper_<A> || isKeyWrapper_<B> > >
+	constexpr bool operator >(A const &a, B const &b){
+		return unwrapKey_(a) > unwrapKey_(b);
+	}
+
+	// AVLSlabMap keeps the values out of the nodes, in a vector.
+	// slot is the index of the value, it changes only in relayout().
+
+	template<typename K>
+	struct Slotted{
+		K			key;
+		mutable uint32_t	slot;
+	};
+
+	template<typename K>
+	constexpr bool isKeyWrapper_<Slotted<K> > = true;
+
+
+
 	template<typename T>
 	struct Node{
 		T data;
 
 		balance_t balance = 0;
 
+		bool dead = false;	// lazy erase, goes in the padding
+
+		prefix_t<T> prefix;
+
 		Node *l	= nullptr;
 		Node *r	= nullptr;
 		Node *p	= nullptr;
 
 		template<typename UT>
 		constexpr Node(UT &&data) :
-						data(std::forward<UT>(data)){}
+						data(std::forward<UT>(data)),
+						prefix(keyPrefixOf_<T>(this->data)){}
 
 		template<typename UT>
 		constexpr Node(UT &&data, Node *p) :
 						data(std::forward<UT>(data)),
+						prefix(keyPrefixOf_<T>(this->data)),
 						p(p){}
 
 		constexpr Node(Node &&other) :
-					data	(std::move(data		)),
-					balance	(std::move(balance	)),
-					l	(std::move(l		)),
-					r	(std::move(r		)),
-					p	(std::move(p		)){}
+					data	(std::move(other.data		)),
+					balance	(std::move(other.balance	)),
+					dead	(std::move(other.dead		)),
+					prefix	(std::move(other.prefix		)),
+					l	(std::move(other.l		)),
+					r	(std::move(other.r		)),
+					p	(std::move(other.p		)){}
 
 		constexpr Node &operator =(Node &&other){
 			using std::swap;
 
 			swap(data	, other.data	);
 			swap(balance	, other.balance	);
+			swap(dead	, other.dead	);
+			swap(prefix	, other.prefix	);
 			swap(l		, other.l	);
 			swap(r		, other.r	);
 			swap(p		, other.p	);
@@ -63,8 +297,8 @@ namespace avl_impl_{
 
 
 
-	template<typename T>
-	Node<T> *minValueNode(Node<T> *node){
+	template<typename N>
+	constexpr N *minValueNode(N *node){
 		if (!node)
 			return nullptr;
 
@@ -74,492 +308,242 @@ namespace avl_impl_{
 		return node;
 	}
 
-	template<typename T>
-	const Node<T> *minValueNode(const Node<T> *node){
+	template<typename N>
+	constexpr N *maxValueNode(N *node){
 		if (!node)
 			return nullptr;
 
-		while(node->l)
-			node = node->l;
+		while(node->r)
+			node = node->r;
 
 		return node;
 	}
 
+	template<typename N>
+	constexpr N *nextNode_(N *node){
+		// left child should be processed.
+		// node       should be processed.
 
+		if (node->r){
+			// go right
+			return minValueNode(node->r);
+		}
 
-	template<typename T>
-	class iterator{
-	public:
-		constexpr iterator(const Node<T> *node) : node(node){}
 
-	public:
-		using difference_type	= std::ptrdiff_t;
-		using value_type	= const T;
-		using pointer		= value_type *;
-		using reference		= value_type &;
-		using iterator_category	= std::forward_iterator_tag;
-		// avl tree can support bi-directiona iterator as well
+		// go up
+		while(node->p){
+			auto *copy = node;
 
-	public:
-		iterator &operator++(){
-			// left child should be processed.
-			// node       should be processed.
+			node = node->p;
 
-			if (node->r){
-				// go right
-				node = minValueNode(node->r);
-				return *this;
+			if (node->l == copy){
+				// we were in left child
+				// process the node
+				return node;
+			}else{
+				// we were in right child
+				// go up again
 			}
+		}
 
+		// we are the root node
+		return nullptr; // std::end()
+	}
 
-			// go up
-			while(node->p){
-				const auto *copy = node;
+	template<typename N>
+	constexpr N *liveNode_(N *node){
+		// skip lazy erased nodes
+		while(node && node->dead)
+			node = nextNode_(node);
 
-				node = node->p;
+		return node;
+	}
 
-				if (node->l == copy){
-					// we were in left child
-					// process the node
-					return *this;
-				}else{
-					// we were in right child
-					// go up again
-				}
-			}
+	template<typename N>
+	constexpr N *prevNode_(N *node){
+		// mirror of nextNode_()
 
-			// we are the root node
-			node = nullptr; // std::end()
-			return *this;
+		if (node->l)
+			return maxValueNode(node->l);
 
-		}
+		while(node->p){
+			auto *copy = node;
 
-		reference operator*() const{
-			return node->data;
-		}
+			node = node->p;
 
-		bool operator==(const iterator &other) const{
-			return node == other.node;
+			if (node->r == copy)
+				return node;
 		}
 
-		bool operator!=(const iterator &other) const{
-			return ! operator==(other);
-		}
+		return nullptr;
+	}
 
-		pointer operator ->() const{
-			return & operator*();
-		}
 
-	private:
-		const Node<T> *node;
-	};
 
+	/*
+	 * Balancing.
+	 *
+	 * Works on any node type with l, r, p and balance = height(r) - height(l),
+	 * so Node<T> and BlockNode<T> share it.
+	 */
 
+	// MerkleAVLTree keeps the hash sum of each subtree in the node, see Merkle.
+	// every change of the links below a node is followed by augment_().
 
-	template<typename T>
-	void printPretty(const Node<T> *node, size_t const pad = 0, char const type = 'B'){
-		// not important, so it stay recursive.
+	template<typename N, typename = void>
+	constexpr bool isMerkleNode_ = false;
 
-		if (!node)
-			return;
+	template<typename N>
+	constexpr bool isMerkleNode_<N, std::void_t<decltype(std::declval<N &>().data.sum)> > = true;
 
-		node->printPretty(pad, type);
-		printPretty(node->l, pad + 1, 'L');
-		printPretty(node->r, pad + 1, 'R');
+	template<typename N>
+	constexpr uint64_t subtreeSum_(const N *node){
+		return node ? node->data.sum : 0;
 	}
 
+	template<typename N>
+	constexpr void augment_(N *node){
+		if constexpr(isMerkleNode_<N>)
+			node->data.sum = node->data.hash + subtreeSum_(node->l) + subtreeSum_(node->r);
+	}
 
+	template<typename N>
+	constexpr void augmentUp_(N *node){
+		// the node and all its parents
 
-	template<typename T, bool CheckHeight = false>
-	void check(const Node<T> *node, const Node<T> *parent = nullptr){
-		// not important, so it stay recursive.
+		if constexpr(isMerkleNode_<N>)
+			for(; node; node = node->p)
+				augment_(node);
+	}
 
-		if (!node)
-			return;
+	template<typename N>
+	constexpr void replaceChild_(N *&root, N *parent, const N *old, N *node){
+		if (!parent)
+			root = node;
+		else if (parent->l == old)
+			parent->l = node;
+		else
+			parent->r = node;
+	}
 
-		assert(node->p == parent);
-		assert(node->balance >= -1 && node->balance <= +1);
+	template<typename N>
+	constexpr void rotateL_(N *&root, N *n){
+		/*
+		 *     n             r
+		 *      \           /
+		 *       r   ==>   n
+		 *      /           \
+		 *     t             t
+		 */
 
-		if constexpr(CheckHeight){
-			auto height = [](const Node<T> *node) -> int{
-				auto _ = [](const auto *node, auto _) -> int{
-					if (!node)
-						return 0;
+		AVL_STAT_(rotations, 1);
 
-					return std::max(
-						_(node->l, _),
-						_(node->r, _)
-					) + 1;
-				};
+		auto *r = n->r;
+		auto *t = r->l;
+		n->r = t;
 
-				return _(node, _);
-			};
+		if (t)
+			t->p = n;
 
-			auto const balance = height(node->r) - height(node->l);
-			assert(balance >= -1 && balance <= +1);
-			assert(balance == node->balance);
-		}
+		r->p = n->p;
 
-		if (node->l)
-			assert(node->l->data < node->data);
+		replaceChild_(root, n->p, n, r);
 
-		if (node->r)
-			assert(node->r->data > node->data);
+		r->l = n;
+		n->p = r;
 
-		check(node->l, node);
-		check(node->r, node);
+		augment_(n);
+		augment_(r);
 	}
 
+	template<typename N>
+	constexpr void rotateR_(N *&root, N *n){
+		/*
+		 *     n             l
+		 *    /               \
+		 *   l       ==>       n
+		 *    \               /
+		 *     t             t
+		 */
 
+		AVL_STAT_(rotations, 1);
 
-} // namespace alv_impl_
-
+		auto *l = n->l;
+		auto *t = l->r;
+		n->l = t;
 
-template<typename T>
-class AVLTree{
-	using Node = typename avl_impl_::Node<T>;
+		if (t)
+			t->p = n;
 
-	Node *root = nullptr;
+		l->p = n->p;
 
-public:
-	~AVLTree(){
-		deallocateTree__(root);
-	}
+		replaceChild_(root, n->p, n, l);
 
-public:
-	using iterator = avl_impl_::iterator<T>;
+		l->r = n;
+		n->p = l;
 
-public:
-	void printPretty() const{
-		return avl_impl_::printPretty(root);
+		augment_(n);
+		augment_(l);
 	}
 
-	void check() const{
-		return avl_impl_::check(root);
+	template<typename N>
+	constexpr void rotateRL_(N *&root, N *node){
+		rotateR_(root, node->r);
+		rotateL_(root, node);
 	}
 
-public:
-	void clear(){
-		deallocateTree__(root);
-		root = nullptr;
+	template<typename N>
+	constexpr void rotateLR_(N *&root, N *node){
+		rotateL_(root, node->l);
+		rotateR_(root, node);
 	}
 
-	template<typename UT>
-	iterator insert(UT &&data){
-		if (!root){
-			// tree is empty.
-			// insert, no balance.
+	template<typename N>
+	constexpr bool rebalanceAfterInsert_(N *&root, N *node){
+		// returns true if the whole tree is one level higher.
 
-			root = allocateNode__(std::forward<UT>(data), nullptr);
+		while(node->balance){
+			if (node->balance == +2){
+				// right heavy
+				if (node->r->balance == +1){
+					AVL_STAT_(writes, 2);
 
-			return root;
-		}
+					node->balance = 0;
+					node->r->balance = 0;
 
-		Node *node   = root;
+					rotateL_(root, node);
+				}else{ // node->r->balance == -1
+					AVL_STAT_(writes, 3);
 
-		while(true){
-			if (data < node->data){
-				if (!node->l){
-					auto *new_node = allocateNode__(std::forward<UT>(data), node);
-					node->l = new_node;
-					--node->balance;
-					rebalanceAfterInsert_(node);
-					return new_node;
-				}else{
-					node = node->l;
-					continue;
+					auto const rlBalance = node->r->l->balance;
+
+					node->r->l->balance = 0;
+					node->r->balance = 0;
+					node->balance = 0;
+
+					if (rlBalance == +1)
+						node->balance = -1;
+					else if (rlBalance == -1)
+						node->r->balance = +1;
+
+					rotateRL_(root, node);
 				}
-			}
-
-			if (data > node->data){
-				if (!node->r){
-					auto *new_node = allocateNode__(std::forward<UT>(data), node);
-					node->r = new_node;
-					++node->balance;
-					rebalanceAfterInsert_(node);
-					return new_node;
-				}else{
-					node = node->r;
-					continue;
-				}
-			}
-
-			if (data == node->data){
-				// found, not insert, no balance.
-				return end();
-			}
-		}
-
-		// never reach here.
-	}
-
-	template<typename UT>
-	bool erase(UT const &key){
-		auto *node = root;
-
-		while(node){
-			if (key < node->data){
-				node = node->l;
-				continue;
-			}
-
-			if (key > node->data){
-				node = node->r;
-				continue;
-			}
-
-			break;
-		}
-
-		if (!node)
-			return false;
-
-		if (node->l && node->r){
-			// CASE 3 - node two children
-			using namespace avl_impl_;
-			auto *successor = minValueNode(node->r);
-
-			using std::swap;
-			swap(node->data, successor->data);
-
-			node = successor;
-		}
-
-		if (auto *child = node->l ? node->l : node->r; child){
-			// CASE 2: node with only one child
-			child->p = node->p;
-
-			if (!node->p){
-				deallocateNode__(node);
-				this->root = child;
-				return true;
-			}
-
-			if (auto *parent = node->p; node == parent->l){
-				parent->l = child;
-				++parent->balance;
-
-				deallocateNode__(node);
-
-				if (parent->balance == +1){
-					return true;
-				}else{
-					rebalanceAfterErase_(parent);
-					return true;
-				}
-			}else{ // node == parent->r
-				parent->r = child;
-				--parent->balance;
-
-				deallocateNode__(node);
-
-				if (parent->balance == -1){
-					return true;
-				}else{
-					rebalanceAfterErase_(parent);
-					return true;
-				}
-			}
-		}
-
-		// CASE 1: node with no children
-
-		if (!node->p){
-			deallocateNode__(node);
-			this->root = nullptr;
-			return true;
-		}
-
-		if (auto *parent = node->p; node == parent->l){
-			parent->l = nullptr;
-			++parent->balance;
-
-			deallocateNode__(node);
-
-			if (parent->balance == +1){
-				return true;
-			}else{
-				rebalanceAfterErase_(parent);
-				return true;
-			}
-		}else{ // node == parent->r
-			parent->r = nullptr;
-			--parent->balance;
-
-			deallocateNode__(node);
-
-			if (parent->balance == -1){
-				return true;
-			}else{
-				rebalanceAfterErase_(parent);
-				return true;
-			}
-		}
-	}
-
-public:
-	template<bool Exact, typename UT>
-	iterator find(UT const &key, std::bool_constant<Exact>) const{
-		auto *node = root;
-
-		while(node){
-			if (key < node->data){
-				if constexpr(!Exact)
-					if (node->l == nullptr)
-						return findFix__(node, key);
-
-				node = node->l;
-				continue;
-			}
-
-			if (key > node->data){
-				if constexpr(!Exact)
-					if (node->r == nullptr)
-						return findFix__(node, key);
-
-				node = node->r;
-				continue;
-			}
-
-			break;
-		}
-
-		return node;
-	}
-
-	iterator begin() const{
-		return avl_impl_::minValueNode(root);
-	}
-
-	constexpr static iterator end(){
-		return nullptr;
-	}
-
-private:
-	template<typename UT>
-	static iterator findFix__(const Node *node, UT const &key){
-		while(node)
-			if (key > node->data)
-				node = node->p;
-			else
-				break;
-
-		return node;
-	}
-
-	template<typename UT>
-	static Node *allocateNode__(UT &&data, Node *parent){
-		return new Node(std::forward<UT>(data), parent);
-	}
-
-	static void deallocateNode__(Node *node){
-		assert(node);
-		delete node;
-	}
-
-	void rotateL_(Node *n){
-		/*
-		 *     n             r
-		 *      \           /
-		 *       r   ==>   n
-		 *      /           \
-		 *     t             t
-		 */
-
-		auto *r = n->r;
-		auto *t = r->l;
-		n->r = t;
-
-		if (t)
-			t->p = n;
-
-		r->p = n->p;
-
-		if (!n->p)
-			this->root = r;
-		else if (n->p->l == n)
-			n->p->l = r;
-		else
-			n->p->r = r;
-
-		r->l = n;
-		n->p = r;
-	}
-
-	void rotateR_(Node *n){
-		/*
-		 *     n             l
-		 *    /               \
-		 *   l       ==>       n
-		 *    \               /
-		 *     t             t
-		 */
-
-		auto *l = n->l;
-		auto *t = l->r;
-		n->l = t;
-
-		if (t)
-			t->p = n;
-
-		l->p = n->p;
-
-		if (!n->p)
-			this->root = l;
-		else if (n->p->r == n)
-			n->p->r = l;
-		else
-			n->p->l = l;
-
-		l->r = n;
-		n->p = l;
-	}
-
-	void rotateRL_(Node *node){
-		rotateR_(node->r);
-		rotateL_(node);
-	}
-
-	void rotateLR_(Node *node){
-		rotateL_(node->l);
-		rotateR_(node);
-	}
-
-	void rebalanceAfterInsert_(Node *node){
-		while(node->balance){
-			if (node->balance == +2){
-				// right heavy
-				if (node->r->balance == +1){
-					node->balance = 0;
-					node->r->balance = 0;
-
-					rotateL_(node);
-				}else{ // node->r->balance == -1
-					auto const rlBalance = node->r->l->balance;
-
-					node->r->l->balance = 0;
-					node->r->balance = 0;
-					node->balance = 0;
-
-					if (rlBalance == +1)
-						node->balance = -1;
-					else if (rlBalance == -1)
-						node->r->balance = +1;
-
-					rotateRL_(node);
-				}
-
-				break;
+
+				break;
 			}
 
 			if (node->balance == -2){
 				// left heavy
 				if (node->l->balance == -1){
+					AVL_STAT_(writes, 2);
+
 					node->balance = 0;
 					node->l->balance = 0;
 
-					rotateR_(node);
+					rotateR_(root, node);
 				}else{ // node->r->balance == +1
+					AVL_STAT_(writes, 3);
+
 					auto const lrBalance = node->l->r->balance;
 
 					node->l->r->balance = 0;
@@ -571,7 +555,7 @@ private:
 					else if (lrBalance == +1)
 						node->l->balance = -1;
 
-					rotateLR_(node);
+					rotateLR_(root, node);
 				}
 
 				break;
@@ -580,7 +564,9 @@ private:
 			auto *parent = node->p;
 
 			if (!parent)
-				return;
+				return true;
+
+			AVL_STAT_(writes, 1);
 
 			if (parent->l == node)
 				--parent->balance;
@@ -589,9 +575,12 @@ private:
 
 			node = node->p;
 		}
+
+		return false;
 	}
 
-	void rebalanceAfterErase_(Node *node){
+	template<typename N>
+	constexpr void rebalanceAfterErase_(N *&root, N *node){
 		assert(node);
 
 		while(true){
@@ -599,16 +588,22 @@ private:
 				// right heavy
 
 				if (node->r->balance == +1){
+					AVL_STAT_(writes, 2);
+
 					node->balance = 0;
 					node->r->balance = 0;
 
-					rotateL_(node);
+					rotateL_(root, node);
 				}else if(node->r->balance == 0){
+					AVL_STAT_(writes, 2);
+
 					node->balance = +1;
 					node->r->balance = -1;
 
-					rotateL_(node);
+					rotateL_(root, node);
 				}else{ // node->r->balance == -1
+					AVL_STAT_(writes, 3);
+
 					auto const rlBalance = node->r->l->balance;
 
 					node->r->l->balance = 0;
@@ -620,7 +615,7 @@ private:
 					else if (rlBalance == -1)
 						node->r->balance = +1;
 
-					rotateRL_(node);
+					rotateRL_(root, node);
 				}
 
 				node = node->p;
@@ -629,16 +624,22 @@ private:
 				// left heavy
 
 				if (node->l->balance == -1){
+					AVL_STAT_(writes, 2);
+
 					node->balance = 0;
-					node->r->balance = 0;
+					node->l->balance = 0;
 
-					rotateR_(node);
+					rotateR_(root, node);
 				}else if(node->l->balance == 0){
+					AVL_STAT_(writes, 2);
+
 					node->balance = -1;
 					node->l->balance = +1;
 
-					rotateR_(node);
+					rotateR_(root, node);
 				}else{ // node->l->balance == +1
+					AVL_STAT_(writes, 3);
+
 					auto const lrBalance = node->l->r->balance;
 
 					node->l->r->balance = 0;
@@ -650,17 +651,24 @@ private:
 					else if (lrBalance == +1)
 						node->l->balance = -1;
 
-					rotateLR_(node);
+					rotateLR_(root, node);
 				}
 
 				node = node->p;
 			}
 
+			// the height did not change,
+			// happens after rotation of a child with balance 0
+			if (node->balance)
+				return;
+
 			auto *parent = node->p;
 
 			if (!parent)
 				return;
 
+			AVL_STAT_(writes, 1);
+
 			if (node == parent->l){
 				++parent->balance;
 
@@ -677,30 +685,5347 @@ private:
 		}
 	}
 
-private:
-	static void deallocateTree__(Node *node){
-		// seems there is no viable iterative alternative
-		if (!node)
-			return;
+	template<typename N>
+	constexpr int rank_(const N *node){
+		// WAVLBalance
+		return node ? node->balance : -1;
+	}
 
-		deallocateTree__(node->l);
-		deallocateTree__(node->r);
-		deallocateNode__(node);
+	template<typename N>
+	constexpr void rebalanceAfterInsertWeak_(N *&root, N *x){
+		// x has the rank of its parent.
+		// promote up, then at most 2 rotations.
+		// same steps as rebalanceAfterInsert_(), written with ranks.
+
+		for(auto *p = x->p; p && p->balance == x->balance; x = p, p = p->p){
+			bool const left = x == p->l;
+
+			if (p->balance - rank_(left ? p->r : p->l) == 1){
+				// 0,1 - promote
+				AVL_STAT_(writes, 1);
+
+				++p->balance;
+				continue;
+			}
+
+			// 0,2 - rotate
+			auto *y = left ? x->r : x->l;
+
+			if (x->balance - rank_(y) == 2){
+				AVL_STAT_(writes, 1);
+
+				left ? rotateR_(root, p) : rotateL_(root, p);
+
+				--p->balance;
+			}else{
+				AVL_STAT_(writes, 3);
+
+				left ? rotateLR_(root, p) : rotateRL_(root, p);
+
+				++y->balance;
+				--x->balance;
+				--p->balance;
+			}
+
+			return;
+		}
 	}
 
-};
+	template<typename N>
+	constexpr void rebalanceAfterEraseWeak_(N *&root, N *p, bool left){
+		// the child on the left / right side of p lost a rank or was removed.
+		// demote up, then at most 2 rotations.
 
+		if (!p->l && !p->r && p->balance == 1){
+			// 2,2 leaf
+			AVL_STAT_(writes, 1);
 
-#include <ctime>
+			--p->balance;
 
-int main(){
-	auto insert = [](auto &tree, auto const &val){
-		auto it = tree.insert(val);
-		assert(*it == val);
-		tree.check();
-	};
+			auto *x = p;
+			p = p->p;
 
-	if constexpr(true){
+			if (!p)
+				return;
+
+			left = x == p->l;
+		}
+
+		while(p->balance - rank_(left ? p->l : p->r) == 3){
+			// sibling is not nullptr, rank of p is at least 2.
+			auto *y = left ? p->r : p->l;
+
+			if (p->balance - y->balance == 2){
+				// 3,2 - demote
+				AVL_STAT_(writes, 1);
+
+				--p->balance;
+			}else if (y->balance - rank_(y->l) == 2 && y->balance - rank_(y->r) == 2){
+				// 3,1 and sibling is 2,2 - demote both
+				AVL_STAT_(writes, 2);
+
+				--p->balance;
+				--y->balance;
+			}else{
+				// 3,1 - rotate
+				auto *v = left ? y->l : y->r;	// inner
+				auto *w = left ? y->r : y->l;	// outer
+
+				if (y->balance - rank_(w) == 1){
+					AVL_STAT_(writes, 2);
+
+					left ? rotateL_(root, p) : rotateR_(root, p);
+
+					++y->balance;
+					--p->balance;
+
+					if (!p->l && !p->r){
+						// 2,2 leaf
+						AVL_STAT_(writes, 1);
+
+						--p->balance;
+					}
+				}else{
+					AVL_STAT_(writes, 3);
+
+					left ? rotateRL_(root, p) : rotateLR_(root, p);
+
+					v->balance += 2;
+					--y->balance;
+					p->balance -= 2;
+				}
+
+				return;
+			}
+
+			auto *x = p;
+			p = p->p;
+
+			if (!p)
+				return;
+
+			left = x == p->l;
+		}
+	}
+
+	template<bool Weak = false, typename N>
+	constexpr void link_(N *&root, N *parent, N *node, bool const left){
+		// node becomes a new leaf under the parent.
+
+		node->l = nullptr;
+		node->r = nullptr;
+		node->p = parent;
+		node->balance = 0;
+
+		if (!parent){
+			// tree is empty.
+			// insert, no balance.
+			root = node;
+			augment_(node);
+			return;
+		}
+
+		if (left)
+			parent->l = node;
+		else
+			parent->r = node;
+
+		augmentUp_(node);
+
+		if constexpr(Weak)
+			return rebalanceAfterInsertWeak_(root, node);
+
+		AVL_STAT_(writes, 1);
+
+		if (left)
+			--parent->balance;
+		else
+			++parent->balance;
+
+		rebalanceAfterInsert_(root, parent);
+	}
+
+	template<bool Weak = false, typename N>
+	constexpr void shorter_(N *&root, N *parent, bool const left){
+		// left / right subtree of the parent is one level lower now.
+
+		if constexpr(Weak)
+			return rebalanceAfterEraseWeak_(root, parent, left);
+
+		AVL_STAT_(writes, 1);
+
+		if (left){
+			++parent->balance;
+
+			if (parent->balance == +1)
+				return;
+		}else{
+			--parent->balance;
+
+			if (parent->balance == -1)
+				return;
+		}
+
+		rebalanceAfterErase_(root, parent);
+	}
+
+	template<bool Weak = false, typename N>
+	constexpr void unlink_(N *&root, N *node){
+		// removes the node from the tree, but does not deallocate it.
+		// the other nodes are not moved, so their iterators stay valid.
+
+		if (node->l && node->r){
+			// CASE 3 - node two children
+			// the successor takes the place and the balance of the node.
+
+			auto *successor = minValueNode(node->r);
+
+			N    *parent;
+			bool left;
+
+			if (successor == node->r){
+				parent	= successor;
+				left	= false;
+			}else{
+				parent	= successor->p;
+				left	= true;
+
+				parent->l = successor->r;
+
+				if (successor->r)
+					successor->r->p = parent;
+
+				successor->r = node->r;
+				node->r->p = successor;
+			}
+
+			successor->l = node->l;
+			node->l->p = successor;
+
+			successor->p = node->p;
+			successor->balance = node->balance;
+
+			AVL_STAT_(writes, 1);
+
+			replaceChild_(root, node->p, node, successor);
+
+			// parent is the lowest changed node, the successor is above it.
+			augmentUp_(parent);
+
+			return shorter_<Weak>(root, parent, left);
+		}
+
+		// CASE 2: node with only one child
+		// or
+		// CASE 1: node with no children
+
+		auto *child  = node->l ? node->l : node->r;
+		auto *parent = node->p;
+
+		if (child)
+			child->p = parent;
+
+		if (!parent){
+			root = child;
+			return;
+		}
+
+		bool const left = node == parent->l;
+
+		replaceChild_(root, parent, node, child);
+
+		augmentUp_(parent);
+
+		shorter_<Weak>(root, parent, left);
+	}
+
+
+
+	template<typename N>
+	constexpr size_t height_(const N *node){
+		// follows the higher child, O(log n)
+
+		size_t h = 0;
+
+		for(; node; ++h)
+			node = node->balance > 0 ? node->r : node->l;
+
+		return h;
+	}
+
+	template<typename T>
+	void vebOrder_(Node<T> *node, size_t height, std::vector<Node<T> *> &order);
+
+	template<typename T>
+	void vebBottom_(Node<T> *node, size_t const depth, size_t const height, std::vector<Node<T> *> &order){
+		// subtrees hanging at depth under the node, left to right
+
+		if (!node)
+			return;
+
+		if (depth == 0)
+			return vebOrder_(node, height, order);
+
+		vebBottom_(node->l, depth - 1, height, order);
+		vebBottom_(node->r, depth - 1, height, order);
+	}
+
+	template<typename T>
+	void vebOrder_(Node<T> *node, size_t const height, std::vector<Node<T> *> &order){
+		// van Emde Boas order of the top height levels under the node:
+		// top half of the levels first, then each bottom subtree, recursively.
+		// O(n log log n)
+
+		if (!node || !height)
+			return;
+
+		if (height == 1)
+			return order.push_back(node);
+
+		size_t const top = height / 2;
+
+		vebOrder_(node, top, order);
+		vebBottom_(node, top, height - top, order);
+	}
+
+
+
+	/*
+	 * Split / join.
+	 *
+	 * Heights are passed down, so they are not recalculated,
+	 * join_() costs O(|hl - hr| + 1) and split_() costs O(log n).
+	 */
+
+	template<typename N>
+	constexpr N *join_(N *l, N *k, N *r, size_t const hl, size_t const hr, size_t &h){
+		// keys in l < k < keys in r, l and r are detached (p == nullptr).
+		// returns the new root, h is its height.
+
+		k->p = nullptr;
+
+		if (hl > hr + 1){
+			// go down the right spine of l to a subtree with height hr or hr + 1,
+			// then k takes its place, like an insert.
+
+			N *root		= l;
+			N *parent	= nullptr;
+			N *c		= l;
+			size_t hc	= hl;
+
+			while(hc > hr + 1){
+				parent = c;
+				hc -= c->balance < 0 ? 2 : 1;
+				c = c->r;
+			}
+
+			k->l = c;
+			k->r = r;
+			k->balance = balance_t(hr - hc);
+
+			if (c)
+				c->p = k;
+
+			if (r)
+				r->p = k;
+
+			k->p = parent;
+			parent->r = k;
+			++parent->balance;
+
+			augmentUp_(k);
+
+			h = hl + rebalanceAfterInsert_(root, parent);
+
+			return root;
+		}
+
+		if (hr > hl + 1){
+			// mirror
+
+			N *root		= r;
+			N *parent	= nullptr;
+			N *c		= r;
+			size_t hc	= hr;
+
+			while(hc > hl + 1){
+				parent = c;
+				hc -= c->balance > 0 ? 2 : 1;
+				c = c->l;
+			}
+
+			k->l = l;
+			k->r = c;
+			k->balance = balance_t(hc - hl);
+
+			if (l)
+				l->p = k;
+
+			if (c)
+				c->p = k;
+
+			k->p = parent;
+			parent->l = k;
+			--parent->balance;
+
+			augmentUp_(k);
+
+			h = hr + rebalanceAfterInsert_(root, parent);
+
+			return root;
+		}
+
+		k->l = l;
+		k->r = r;
+		k->balance = balance_t(hr - hl);
+
+		if (l)
+			l->p = k;
+
+		if (r)
+			r->p = k;
+
+		augment_(k);
+
+		h = std::max(hl, hr) + 1;
+
+		return k;
+	}
+
+	template<typename N>
+	constexpr N *join_(N *l, N *r, size_t const hl, size_t hr){
+		// same, without middle key, the min of r is used.
+
+		if (!l)
+			return r;
+
+		if (!r)
+			return l;
+
+		auto *k = minValueNode(r);
+
+		unlink_(r, k);
+
+		hr = height_(r);
+
+		size_t h;
+		return join_(l, k, r, hl, hr, h);
+	}
+
+	template<typename N, typename F>
+	constexpr void split_(N *node, size_t const h, F &goesLeft, N *&l, size_t &hl, N *&r, size_t &hr){
+		// keys x with goesLeft(x) go to l, the others to r.
+		// goesLeft must be true for a prefix of the keys.
+
+		if (!node){
+			l  = r  = nullptr;
+			hl = hr = 0;
+			return;
+		}
+
+		auto *nl = node->l;
+		auto *nr = node->r;
+
+		size_t const hnl = h - (node->balance > 0 ? 2 : 1);
+		size_t const hnr = h - (node->balance < 0 ? 2 : 1);
+
+		if (nl)
+			nl->p = nullptr;
+
+		if (nr)
+			nr->p = nullptr;
+
+		if (goesLeft(node->data)){
+			// node and the left subtree go left
+			N	*rl;
+			size_t	hrl;
+
+			split_(nr, hnr, goesLeft, rl, hrl, r, hr);
+			l = join_(nl, node, rl, hnl, hrl, hl);
+		}else{
+			// node and the right subtree go right
+			N	*lr;
+			size_t	hlr;
+
+			split_(nl, hnl, goesLeft, l, hl, lr, hlr);
+			r = join_(lr, node, nr, hlr, hnr, hr);
+		}
+	}
+
+
+
+	constexpr uint8_t bitWidth_(uint64_t x){
+		uint8_t w = 0;
+
+		for(; x; x >>= 1)
+			++w;
+
+		return w;
+	}
+
+	template<bool Weak>
+	constexpr balance_t builtBalance_(size_t const sizeL, size_t const sizeR){
+		// height of a tree made by buildBalanced_() is bitWidth_(size)
+
+		if constexpr(Weak)
+			return balance_t(bitWidth_(sizeL + sizeR + 1) - 1);
+		else
+			return balance_t(bitWidth_(sizeR) - bitWidth_(sizeL));
+	}
+
+	template<typename T, bool Weak = false, typename F>
+	constexpr Node<T> *buildBalanced_(size_t const size, Node<T> *parent, F &&next){
+		// next() must return the nodes in sorted order.
+		// links and balance are set here, so the nodes can be new or reused.
+		// recursion depth is log2(size).
+
+		if (!size)
+			return nullptr;
+
+		size_t const sizeL = (size - 1) / 2;
+		size_t const sizeR = size - 1 - sizeL;
+
+		Node<T> *l    = buildBalanced_<T, Weak>(sizeL, nullptr, next);
+		Node<T> *node = next();
+
+		node->p = parent;
+
+		node->l = l;
+		if (l)
+			l->p = node;
+
+		node->r = buildBalanced_<T, Weak>(sizeR, node, next);
+
+		node->balance = builtBalance_<Weak>(sizeL, sizeR);
+
+		augment_(node);
+
+		return node;
+	}
+
+
+
+	// smaller parts are not worth a thread
+	constexpr size_t PARALLEL_MIN_SIZE = 1 << 14;
+
+	template<typename F1, typename F2>
+	void forkJoin_(unsigned const threads, F1 &&f1, F2 &&f2){
+		// f1 on a new thread, f2 on this one.
+
+		if (threads < 2){
+			f1();
+			f2();
+			return;
+		}
+
+		std::thread t{ std::forward<F1>(f1) };
+
+		f2();
+
+		t.join();
+	}
+
+	template<typename T>
+	void parallelSort_(T *first, size_t const size, unsigned const threads){
+		if (threads < 2 || size < PARALLEL_MIN_SIZE)
+			return std::sort(first, first + size);
+
+		size_t const half = size / 2;
+
+		forkJoin_(threads,
+			[&](){ parallelSort_(first,        half,        threads / 2			); },
+			[&](){ parallelSort_(first + half, size - half, threads - threads / 2	); }
+		);
+
+		std::inplace_merge(first, first + half, first + size);
+	}
+
+	template<typename T, bool Weak = false>
+	Node<T> *buildParallel_(Node<T> *nodes, T *values, size_t const size, Node<T> *parent, unsigned const threads){
+		// values are sorted and unique, nodes[i] is made from values[i].
+		// each subtree is a slice of both arrays,
+		// so the top subtrees are built on separate threads without locks.
+		// same shape as buildBalanced_().
+
+		if (threads < 2 || size < PARALLEL_MIN_SIZE){
+			size_t i = 0;
+
+			return buildBalanced_<T, Weak>(size, parent, [&](){
+				auto *node = new (nodes + i) Node<T>(std::move(values[i]));
+				++i;
+				return node;
+			});
+		}
+
+		if (!size)
+			return nullptr;
+
+		size_t const sizeL = (size - 1) / 2;
+		size_t const sizeR = size - 1 - sizeL;
+
+		auto *node = new (nodes + sizeL) Node<T>(std::move(values[sizeL]), parent);
+
+		forkJoin_(threads,
+			[&](){ node->l = buildParallel_<T, Weak>(nodes,             values,             sizeL, node, threads / 2		); },
+			[&](){ node->r = buildParallel_<T, Weak>(nodes + sizeL + 1, values + sizeL + 1, sizeR, node, threads - threads / 2	); }
+		);
+
+		node->balance = builtBalance_<Weak>(sizeL, sizeR);
+
+		augment_(node);
+
+		return node;
+	}
+
+
+
+	template<typename T>
+	class iterator{
+	public:
+		constexpr iterator(const Node<T> *node) : node(node){}
+
+	public:
+		using difference_type	= std::ptrdiff_t;
+		using value_type	= const T;
+		using pointer		= value_type *;
+		using reference		= value_type &;
+		using iterator_category	= std::forward_iterator_tag;
+		// avl tree can support bi-directiona iterator as well
+
+	public:
+		constexpr iterator &operator++(){
+			node = liveNode_(nextNode_(node));
+			return *this;
+		}
+
+		constexpr reference operator*() const{
+			return node->data;
+		}
+
+		constexpr bool operator==(const iterator &other) const{
+			return node == other.node;
+		}
+
+		constexpr bool operator!=(const iterator &other) const{
+			return ! operator==(other);
+		}
+
+		constexpr pointer operator ->() const{
+			return & operator*();
+		}
+
+		// for AVLTree::extract()
+		constexpr const Node<T> *node_() const{
+			return node;
+		}
+
+	private:
+		const Node<T> *node;
+	};
+
+
+
+	/*
+	 * Hash index:
+	 *
+	 *   optional, exact find() in O(1), see AVLTree::set_hash_index().
+	 *   open addressing, linear probing, at most 3/4 full.
+	 *   slots keep the hash, so the node is read only when the hash is equal.
+	 *   erase moves the next slots back, no tombstones.
+	 */
+
+	template<typename T>
+	constexpr bool isHashable_ = isStringKey_<T> || std::is_default_constructible_v<std::hash<T> >;
+
+	template<typename T, typename UT>
+	constexpr bool isHashLookup_ = isHashable_<T> &&
+					(std::is_same_v<T, UT> || (isStringKey_<T> && std::is_convertible_v<UT const &, std::string_view>));
+
+	template<typename T, typename UT>
+	uint64_t hashKey_(UT const &key){
+		uint64_t h;
+
+		// std::hash<std::string> is the same as std::hash<std::string_view>
+		if constexpr(isStringKey_<T>)
+			h = std::hash<std::string_view>{}(key);
+		else
+			h = std::hash<T>{}(key);
+
+		// std::hash of integers is the identity, Fibonacci hashing spreads it to the high bits.
+		return h * 0x9E3779B97F4A7C15ull;
+	}
+
+	template<typename T>
+	class HashIndex{
+		using N = Node<T>;
+
+		struct Slot{
+			uint64_t	hash	= 0;
+			N		*node	= nullptr;	// nullptr - empty
+		};
+
+		std::vector<Slot>	slots;
+		size_t			size	= 0;
+		uint8_t			shift	= 64;	// slot is hash >> shift
+
+	public:
+		constexpr bool enabled() const{
+			return !slots.empty();
+		}
+
+		void assign(size_t const count){
+			// enabled and empty, room for count nodes.
+
+			auto const bits = std::max<uint8_t>(bitWidth_(count + count / 3), 4);
+
+			slots.assign(size_t{ 1 } << bits, Slot{});
+			size	= 0;
+			shift	= uint8_t(64 - bits);
+		}
+
+		constexpr void disable(){
+			slots	= {};
+			size	= 0;
+			shift	= 64;
+		}
+
+		void insert(N *node){
+			if (4 * (size + 1) > 3 * slots.size())
+				grow_();
+
+			insert_(hashKey_<T>(node->data), node);
+			++size;
+		}
+
+		void erase(const N *node){
+			auto const mask = slots.size() - 1;
+
+			for(size_t i = hashKey_<T>(node->data) >> shift; slots[i].node; i = (i + 1) & mask){
+				if (slots[i].node != node)
+					continue;
+
+				// backward shift, a slot moves into the hole
+				// unless its home is between the hole and the slot.
+				size_t hole = i;
+
+				for(size_t j = (i + 1) & mask; slots[j].node; j = (j + 1) & mask){
+					size_t const home = slots[j].hash >> shift;
+
+					if (((j - home) & mask) >= ((j - hole) & mask)){
+						slots[hole] = slots[j];
+						hole = j;
+					}
+				}
+
+				slots[hole] = {};
+				--size;
+
+				return;
+			}
+		}
+
+		template<typename UT>
+		const N *find(UT const &key) const{
+			auto const mask = slots.size() - 1;
+			auto const hash = hashKey_<T>(key);
+
+			for(size_t i = hash >> shift; slots[i].node; i = (i + 1) & mask){
+				auto const &slot = slots[i];
+
+				if (slot.hash == hash && !(key < slot.node->data) && !(key > slot.node->data))
+					return slot.node;
+			}
+
+			return nullptr;
+		}
+
+	private:
+		void insert_(uint64_t const hash, N *node){
+			auto const mask = slots.size() - 1;
+
+			size_t i = hash >> shift;
+
+			while(slots[i].node)
+				i = (i + 1) & mask;
+
+			slots[i] = { hash, node };
+		}
+
+		void grow_(){
+			auto old = std::move(slots);
+
+			slots.assign(old.size() * 2, Slot{});
+			--shift;
+
+			for(auto const &slot : old)
+				if (slot.node)
+					insert_(slot.hash, slot.node);
+		}
+	};
+
+
+
+	/*
+	 * Front cache:
+	 *
+	 *   optional, exact find() of a hot key goes to its node without a descent,
+	 *   see AVLTree::set_front_cache().
+	 *   direct mapped by the key hash, a miss that finds the key takes the slot,
+	 *   erase of the node clears it.
+	 */
+
+	struct FrontCacheStats{
+		size_t hits	= 0;
+		size_t misses	= 0;
+	};
+
+	template<typename T>
+	class FrontCache{
+		using N = Node<T>;
+
+		struct Slot{
+			uint64_t	hash	= 0;
+			const N		*node	= nullptr;	// nullptr - empty
+		};
+
+		std::vector<Slot>	slots;
+		uint8_t			shift	= 64;	// slot is hash >> shift
+
+	public:
+		FrontCacheStats		stats;
+
+	public:
+		explicit FrontCache(size_t const size){
+			// size is rounded up to a power of 2, at least 2.
+
+			auto const bits = std::max<uint8_t>(bitWidth_(size - 1), 1);
+
+			slots.assign(size_t{ 1 } << bits, Slot{});
+			shift = uint8_t(64 - bits);
+		}
+
+		size_t size() const{
+			return slots.size();
+		}
+
+		void clear(){
+			std::fill(std::begin(slots), std::end(slots), Slot{});
+		}
+
+		template<typename UT>
+		const N *find(UT const &key, uint64_t const hash){
+			auto const &slot = slots[hash >> shift];
+
+			if (slot.node && slot.hash == hash && !(key < slot.node->data) && !(key > slot.node->data)){
+				++stats.hits;
+				return slot.node;
+			}
+
+			++stats.misses;
+			return nullptr;
+		}
+
+		void store(uint64_t const hash, const N *node){
+			slots[hash >> shift] = { hash, node };
+		}
+
+		void erase(const N *node){
+			auto &slot = slots[hashKey_<T>(node->data) >> shift];
+
+			if (slot.node == node)
+				slot = {};
+		}
+	};
+
+
+
+	/*
+	 * Merkle:
+	 *
+	 *   MerkleAVLTree node value, the key, its hash and the hash sum of the subtree.
+	 *   the sum does not depend on the shape of the tree,
+	 *   so replicas with the same keys have the same sums for the same key ranges.
+	 */
+
+	inline uint64_t mix64_(uint64_t x){
+		// splitmix64, the sums need a hash that is not linear in the key
+		// and is not 0 for the key 0.
+
+		x += 0x9E3779B97F4A7C15ull;
+		x ^= x >> 30;
+		x *= 0xBF58476D1CE4E5B9ull;
+		x ^= x >> 27;
+		x *= 0x94D049BB133111EBull;
+		x ^= x >> 31;
+
+		return x;
+	}
+
+	template<typename T>
+	struct Merkle{
+		T		key;
+		uint64_t	hash;
+		uint64_t	sum;	// see augment_()
+
+		Merkle(T key) :	key(std::move(key)),
+				hash(mix64_(hashKey_<T>(this->key))),
+				sum(hash){}
+	};
+
+	template<typename T>
+	constexpr bool isKeyWrapper_<Merkle<T> > = true;
+
+
+
+	/*
+	 * Bloom filter:
+	 *
+	 *   optional, exact find() of an absent key stops here most of the time,
+	 *   see AVLTree::set_bloom_filter().
+	 *   blocked, all bits of a key are in one 64 byte block, one cache miss per lookup.
+	 *   bits can not be cleared, so the owner rebuilds it, see stale().
+	 */
+
+	class BloomFilter{
+		constexpr static size_t BLOCK_WORDS	= 8;
+		constexpr static size_t BLOCK_BITS	= BLOCK_WORDS * 64;
+
+		std::vector<uint64_t>	bits;
+		size_t			blocks;
+		uint8_t			k;		// bits per key
+
+	public:
+		size_t			bitsPerKey;
+		size_t			capacity;	// keys it was sized for
+		size_t			added	= 0;
+		size_t			erased	= 0;
+
+	public:
+		BloomFilter(size_t const bitsPerKey, size_t const count) :
+					bitsPerKey(bitsPerKey),
+					capacity(std::max<size_t>(count + count / 2, BLOCK_BITS)){
+
+			blocks	= (capacity * bitsPerKey + BLOCK_BITS - 1) / BLOCK_BITS;
+			k	= uint8_t(std::clamp<size_t>(bitsPerKey * 69 / 100, 1, 16));	// ln 2
+
+			bits.assign(blocks * BLOCK_WORDS, 0);
+		}
+
+		void insert(uint64_t const hash){
+			auto *block = block_(hash);
+
+			probe_(hash, [block](size_t const bit){
+				block[bit / 64] |= uint64_t{ 1 } << (bit % 64);
+				return true;
+			});
+
+			++added;
+		}
+
+		bool mayContain(uint64_t const hash) const{
+			const auto *block = block_(hash);
+
+			return probe_(hash, [block](size_t const bit){
+				return block[bit / 64] >> (bit % 64) & 1;
+			});
+		}
+
+		bool stale() const{
+			// too full for the false positive rate, or too many erased keys left in.
+			return added > capacity || 2 * erased > capacity;
+		}
+
+		size_t bytes() const{
+			return bits.size() * sizeof(uint64_t);
+		}
+
+	private:
+		const uint64_t *block_(uint64_t const hash) const{
+			// the high bits of hashKey_() pick the block, no modulo.
+			return bits.data() + ((hash >> 32) * blocks >> 32) * BLOCK_WORDS;
+		}
+
+		uint64_t *block_(uint64_t const hash){
+			return const_cast<uint64_t *>(std::as_const(*this).block_(hash));
+		}
+
+		template<typename F>
+		bool probe_(uint64_t const hash, F f) const{
+			// double hashing in the block, from a second hash,
+			// the low bits of hashKey_() are weak.
+
+			auto const h = mix64_(hash);
+
+			auto	bit	= uint32_t(h);
+			auto	step	= uint32_t(h >> 32) | 1;
+
+			for(uint8_t i = 0; i < k; ++i, bit += step)
+				if (!f(bit % BLOCK_BITS))
+					return false;
+
+			return true;
+		}
+	};
+
+
+
+	template<typename T>
+	void printPretty(const Node<T> *node, size_t const pad = 0, char const type = 'B'){
+		// not important, so it stay recursive.
+
+		if (!node)
+			return;
+
+		node->printPretty(pad, type);
+		printPretty(node->l, pad + 1, 'L');
+		printPretty(node->r, pad + 1, 'R');
+	}
+
+
+
+	template<typename T, bool CheckHeight = false>
+	void check(const Node<T> *node, const Node<T> *parent = nullptr){
+		// not important, so it stay recursive.
+
+		if (!node)
+			return;
+
+		assert(node->p == parent);
+		assert(node->balance >= -1 && node->balance <= +1);
+
+		if constexpr(hasPrefix_<T>)
+			assert(node->prefix == keyPrefix_(node->data));
+
+		if constexpr(CheckHeight){
+			auto height = [](const Node<T> *node) -> int{
+				auto _ = [](const auto *node, auto _) -> int{
+					if (!node)
+						return 0;
+
+					return std::max(
+						_(node->l, _),
+						_(node->r, _)
+					) + 1;
+				};
+
+				return _(node, _);
+			};
+
+			auto const balance = height(node->r) - height(node->l);
+			assert(balance >= -1 && balance <= +1);
+			assert(balance == node->balance);
+		}
+
+		if (node->l)
+			assert(node->l->data < node->data);
+
+		if (node->r)
+			assert(node->r->data > node->data);
+
+		check(node->l, node);
+		check(node->r, node);
+	}
+
+	template<typename T>
+	void checkWeak(const Node<T> *node, const Node<T> *parent = nullptr){
+		// WAVLBalance, not important, so it stay recursive.
+
+		if (!node)
+			return;
+
+		assert(node->p == parent);
+
+		auto const dl = node->balance - rank_(node->l);
+		auto const dr = node->balance - rank_(node->r);
+
+		assert(dl >= 1 && dl <= 2);
+		assert(dr >= 1 && dr <= 2);
+
+		if (!node->l && !node->r)
+			assert(node->balance == 0);
+
+		if constexpr(hasPrefix_<T>)
+			assert(node->prefix == keyPrefix_(node->data));
+
+		if (node->l)
+			assert(node->l->data < node->data);
+
+		if (node->r)
+			assert(node->r->data > node->data);
+
+		checkWeak(node->l, node);
+		checkWeak(node->r, node);
+	}
+
+
+
+	/*
+	 * Block node:
+	 *
+	 *   sorted keys in a small array, the blocks are ordered like single keys.
+	 *   links are first, so l, r and data[0] used in the descent share a cache line.
+	 */
+
+	template<typename T, size_t Capacity>
+	struct BlockNode{
+		static_assert(std::is_trivially_copyable_v<T>,	"BlockNode supports trivially copyable types only");
+		static_assert(Capacity >= 4 && Capacity <= 0xFFFF,	"BlockNode capacity must be in [4, 65535]");
+
+		BlockNode *l	= nullptr;
+		BlockNode *r	= nullptr;
+		BlockNode *p	= nullptr;
+
+		balance_t balance = 0;
+
+		uint16_t size	= 0;
+
+		T data[Capacity];
+
+		// unused slots hold the max key, so the search does not need the size.
+		constexpr static T EMPTY = std::numeric_limits<T>::max();
+
+		BlockNode(){
+			std::fill(data, data + Capacity, EMPTY);
+		}
+	};
+
+	template<typename T, size_t Capacity, typename UT>
+	size_t blockLowerBound_(const BlockNode<T, Capacity> *node, UT const &key){
+		if constexpr(std::is_arithmetic_v<T>){
+			// fixed trip count and no branches, so it compiles to SIMD compares.
+			// unused slots are EMPTY, not less than any key,
+			// except +inf and NaN for floating point, so the count is clamped.
+
+			unsigned n = 0;
+
+			for(size_t i = 0; i < Capacity; ++i)
+				n += key > node->data[i];
+
+			return std::min<size_t>(n, node->size);
+		}else{
+			auto const *it = std::lower_bound(node->data, node->data + node->size, key, [](T const &a, UT const &key){
+				return key > a;
+			});
+
+			return size_t(it - node->data);
+		}
+	}
+
+	template<typename T, size_t Capacity>
+	class block_iterator{
+	public:
+		constexpr block_iterator(const BlockNode<T, Capacity> *node, size_t index) : node(node), index(index){}
+
+	public:
+		using difference_type	= std::ptrdiff_t;
+		using value_type	= const T;
+		using pointer		= value_type *;
+		using reference		= value_type &;
+		using iterator_category	= std::forward_iterator_tag;
+
+	public:
+		block_iterator &operator++(){
+			if (++index == node->size){
+				node  = nextNode_(node);
+				index = 0;
+			}
+
+			return *this;
+		}
+
+		reference operator*() const{
+			return node->data[index];
+		}
+
+		bool operator==(const block_iterator &other) const{
+			return node == other.node && index == other.index;
+		}
+
+		bool operator!=(const block_iterator &other) const{
+			return ! operator==(other);
+		}
+
+		pointer operator ->() const{
+			return & operator*();
+		}
+
+	private:
+		const BlockNode<T, Capacity>	*node;
+		size_t				index;
+	};
+
+	template<typename T, size_t Capacity>
+	void check(const BlockNode<T, Capacity> *node, const BlockNode<T, Capacity> *parent = nullptr){
+		// not important, so it stay recursive.
+
+		if (!node)
+			return;
+
+		assert(node->p == parent);
+		assert(node->balance >= -1 && node->balance <= +1);
+		assert(node->size > 0 && node->size <= Capacity);
+
+		for(size_t i = 1; i < node->size; ++i)
+			assert(node->data[i - 1] < node->data[i]);
+
+		if (auto *prev = maxValueNode(node->l))
+			assert(prev->data[prev->size - 1] < node->data[0]);
+
+		if (auto *next = minValueNode(node->r))
+			assert(next->data[0] > node->data[node->size - 1]);
+
+		check(node->l, node);
+		check(node->r, node);
+	}
+
+
+	inline void prefetch_(const void *p){
+	#if defined(__GNUC__)
+		__builtin_prefetch(p);
+	#else
+		(void) p;
+	#endif
+	}
+
+	constexpr unsigned countTrailingOnes_(size_t x){
+	#if defined(__GNUC__)
+		return unsigned(__builtin_ctzll(~uint64_t{x}));
+	#else
+		unsigned n = 0;
+
+		for(; x & 1; x >>= 1)
+			++n;
+
+		return n;
+	#endif
+	}
+
+
+
+	/*
+	 * Eytzinger layout:
+	 *
+	 *   1-based array, children of k are 2k and 2k+1, the root is 1, 0 is end().
+	 *
+	 *   the 16 nodes 4 levels below k are at 16k .. 16k+15,
+	 *   so one prefetch brings them in while the search continues.
+	 */
+
+	template<typename T>
+	constexpr size_t EYTZINGER_PREFETCH = sizeof(T) < 64 ? 64 / sizeof(T) : 1;
+
+	template<typename T, typename It>
+	constexpr void eytzingerFill_(T *data, size_t const size, size_t const k, It &it){
+		// in-order, recursion depth is log2(size).
+
+		if (k > size)
+			return;
+
+		eytzingerFill_(data, size, 2 * k, it);
+
+		data[k] = *it;
+		++it;
+
+		eytzingerFill_(data, size, 2 * k + 1, it);
+	}
+
+	template<bool Exact, typename T, typename UT>
+	constexpr size_t eytzingerFind_(const T *data, size_t const size, UT const &key){
+		size_t k = 1;
+
+		while(k <= size){
+			if (!isConstantEvaluated_())
+				prefetch_(data + k * EYTZINGER_PREFETCH<T>);
+
+			// branchless, compiles to setcc + lea.
+			k = 2 * k + (key > data[k]);
+		}
+
+		// undo the right turns after the last left turn.
+		// k is the first node not less than the key.
+		k >>= countTrailingOnes_(k) + 1;
+
+		if constexpr(Exact)
+			if (k && key < data[k])
+				return 0;
+
+		return k;
+	}
+
+	template<typename T>
+	class eytzinger_iterator{
+	public:
+		constexpr eytzinger_iterator(const T *data, size_t size, size_t k) : data(data), size(size), k(k){}
+
+	public:
+		using difference_type	= std::ptrdiff_t;
+		using value_type	= const T;
+		using pointer		= value_type *;
+		using reference		= value_type &;
+		using iterator_category	= std::forward_iterator_tag;
+
+	public:
+		constexpr eytzinger_iterator &operator++(){
+			if (2 * k + 1 <= size){
+				// go right, then leftmost
+				k = 2 * k + 1;
+
+				while(2 * k <= size)
+					k = 2 * k;
+			}else{
+				// go up while we are right child, then up once more.
+				// the root goes to 0, e.g. std::end()
+				k >>= countTrailingOnes_(k) + 1;
+			}
+
+			return *this;
+		}
+
+		constexpr reference operator*() const{
+			return data[k];
+		}
+
+		constexpr bool operator==(const eytzinger_iterator &other) const{
+			return k == other.k;
+		}
+
+		constexpr bool operator!=(const eytzinger_iterator &other) const{
+			return ! operator==(other);
+		}
+
+		constexpr pointer operator ->() const{
+			return & operator*();
+		}
+
+	private:
+		const T	*data;
+		size_t	size;
+		size_t	k;
+	};
+
+
+
+	/*
+	 * Snapshot:
+	 *
+	 *   'A' 'V' 'L' 'S' | format : u8 | sizeof(T) : u8 | size : varint | payload
+	 *
+	 * Raw         - size * T, host byte order.
+	 *
+	 * DeltaPacked - integral T only.
+	 *               first key as varint, then the gaps (delta - 1),
+	 *               in blocks of SNAPSHOT_BLOCK_SIZE:
+	 *
+	 *                 base : varint | width : u8 | (gap - base) bit-packed, width bits each
+	 *
+	 *               dense keys have all gaps 0 and cost 2 bytes per block.
+	 */
+
+	enum class SnapshotFormat : uint8_t{
+		Raw		= 0,
+		DeltaPacked	= 1
+	};
+
+	constexpr char		SNAPSHOT_MAGIC[4]	= { 'A', 'V', 'L', 'S' };
+	constexpr size_t	SNAPSHOT_BLOCK_SIZE	= 128;
+
+	template<typename T>
+	constexpr bool isPackable_ = std::is_integral_v<T> && !std::is_same_v<T, bool>;
+
+	template<typename T>
+	constexpr auto toOrdered_(T const x){
+		// signed to unsigned, order preserving
+
+		using U = std::make_unsigned_t<T>;
+
+		if constexpr(std::is_signed_v<T>)
+			return U(U(x) ^ (U(1) << (sizeof(T) * 8 - 1)));
+		else
+			return U(x);
+	}
+
+	template<typename T>
+	constexpr T fromOrdered_(std::make_unsigned_t<T> const u){
+		using U = std::make_unsigned_t<T>;
+
+		if constexpr(std::is_signed_v<T>)
+			return T(U(u ^ (U(1) << (sizeof(T) * 8 - 1))));
+		else
+			return T(u);
+	}
+
+	inline void writeVarint_(std::ostream &os, uint64_t x){
+		while(x >= 0x80){
+			os.put(char(x | 0x80));
+			x >>= 7;
+		}
+
+		os.put(char(x));
+	}
+
+	inline bool readVarint_(std::istream &is, uint64_t &x){
+		x = 0;
+
+		for(unsigned shift = 0; shift < 64; shift += 7){
+			auto const c = is.get();
+
+			if (c == std::istream::traits_type::eof())
+				return false;
+
+			x |= uint64_t(c & 0x7F) << shift;
+
+			if (!(c & 0x80))
+				return true;
+		}
+
+		return false;
+	}
+
+	inline void writePacked_(std::ostream &os, const uint64_t *data, size_t const count, uint8_t const width){
+		uint64_t words[SNAPSHOT_BLOCK_SIZE + 1] = {};
+
+		for(size_t i = 0; i < count; ++i){
+			size_t   const pos   = i * width;
+			unsigned const shift = pos % 64;
+
+			words[pos / 64] |= data[i] << shift;
+
+			if (shift + width > 64)
+				words[pos / 64 + 1] |= data[i] >> (64 - shift);
+		}
+
+		size_t const bytes = (count * width + 7) / 8;
+
+		for(size_t i = 0; i < bytes; ++i)
+			os.put(char(words[i / 8] >> (i % 8 * 8)));
+	}
+
+	inline bool readPacked_(std::istream &is, uint64_t *data, size_t const count, uint8_t const width){
+		uint64_t words[SNAPSHOT_BLOCK_SIZE + 1] = {};
+
+		size_t const bytes = (count * width + 7) / 8;
+
+		for(size_t i = 0; i < bytes; ++i){
+			auto const c = is.get();
+
+			if (c == std::istream::traits_type::eof())
+				return false;
+
+			words[i / 8] |= uint64_t(uint8_t(c)) << (i % 8 * 8);
+		}
+
+		// no data dependent branches, so the compiler can vectorize it.
+		// (x << 1) << (63 - shift) is 0 when shift is 0.
+
+		uint64_t const mask = width == 64 ? ~uint64_t{0} : (uint64_t{1} << width) - 1;
+
+		for(size_t i = 0; i < count; ++i){
+			size_t   const pos   = i * width;
+			unsigned const shift = pos % 64;
+
+			uint64_t const lo = words[pos / 64    ] >> shift;
+			uint64_t const hi = words[pos / 64 + 1] << 1 << (63 - shift);
+
+			data[i] = (lo | hi) & mask;
+		}
+
+		return true;
+	}
+
+	template<typename T, typename It>
+	void writeDeltaPacked_(std::ostream &os, It it, size_t const size){
+		using U = std::make_unsigned_t<T>;
+
+		if (!size)
+			return;
+
+		U prev = toOrdered_(*it);
+		++it;
+
+		writeVarint_(os, prev);
+
+		uint64_t block[SNAPSHOT_BLOCK_SIZE];
+
+		for(size_t left = size - 1; left;){
+			size_t const count = std::min(left, SNAPSHOT_BLOCK_SIZE);
+
+			uint64_t base = std::numeric_limits<uint64_t>::max();
+
+			for(size_t i = 0; i < count; ++i, ++it){
+				U const u = toOrdered_(*it);
+
+				// keys are sorted and unique, so delta is at least 1
+				block[i] = U(u - prev - 1);
+				prev = u;
+
+				base = std::min(base, block[i]);
+			}
+
+			uint64_t spread = 0;
+
+			for(size_t i = 0; i < count; ++i)
+				spread |= block[i] -= base;
+
+			uint8_t const width = bitWidth_(spread);
+
+			writeVarint_(os, base);
+			os.put(char(width));
+			writePacked_(os, block, count, width);
+
+			left -= count;
+		}
+	}
+
+	template<typename T>
+	bool readDeltaPacked_(std::istream &is, size_t const size, std::vector<T> &values){
+		using U = std::make_unsigned_t<T>;
+
+		if (!size)
+			return true;
+
+		uint64_t first;
+		if (!readVarint_(is, first) || first > std::numeric_limits<U>::max())
+			return false;
+
+		U prev = U(first);
+		values.push_back(fromOrdered_<T>(prev));
+
+		uint64_t block[SNAPSHOT_BLOCK_SIZE];
+
+		for(size_t left = size - 1; left;){
+			size_t const count = std::min(left, SNAPSHOT_BLOCK_SIZE);
+
+			uint64_t base;
+			if (!readVarint_(is, base))
+				return false;
+
+			auto const width = is.get();
+			if (width == std::istream::traits_type::eof() || width > 64)
+				return false;
+
+			if (!readPacked_(is, block, count, uint8_t(width)))
+				return false;
+
+			for(size_t i = 0; i < count; ++i){
+				prev = U(prev + 1 + base + block[i]);
+				values.push_back(fromOrdered_<T>(prev));
+			}
+
+			left -= count;
+		}
+
+		return true;
+	}
+
+	template<typename T, typename It>
+	void saveSnapshot(std::ostream &os, It it, size_t const size, SnapshotFormat const format){
+		static_assert(std::is_trivially_copyable_v<T>, "Snapshot supports trivially copyable types only");
+
+		assert(format == SnapshotFormat::Raw || isPackable_<T>);
+
+		os.write(SNAPSHOT_MAGIC, sizeof SNAPSHOT_MAGIC);
+		os.put(char(format));
+		os.put(char(sizeof(T)));
+		writeVarint_(os, size);
+
+		if constexpr(isPackable_<T>)
+			if (format == SnapshotFormat::DeltaPacked)
+				return writeDeltaPacked_<T>(os, it, size);
+
+		for(size_t i = 0; i < size; ++i, ++it){
+			T const &x = *it;
+			os.write(reinterpret_cast<const char *>(&x), sizeof(T));
+		}
+	}
+
+	template<typename T>
+	bool loadSnapshot(std::istream &is, std::vector<T> &values){
+		static_assert(std::is_trivially_copyable_v<T>, "Snapshot supports trivially copyable types only");
+
+		char magic[sizeof SNAPSHOT_MAGIC];
+
+		if (!is.read(magic, sizeof magic) || !std::equal(magic, magic + sizeof magic, SNAPSHOT_MAGIC))
+			return false;
+
+		auto const format = is.get();
+		auto const sizeT  = is.get();
+
+		uint64_t size;
+
+		if (sizeT != sizeof(T) || !readVarint_(is, size) || size > values.max_size())
+			return false;
+
+		values.clear();
+
+		// the size is not trusted, the vector grows with the keys read,
+		// so a corrupt size fails on the short read, not on the allocation.
+		constexpr size_t CHUNK = 1 << 16;
+
+		switch(format){
+		case uint8_t(SnapshotFormat::Raw):
+			for(uint64_t left = size; left;){
+				size_t const count = size_t(std::min<uint64_t>(left, CHUNK));
+				size_t const done  = values.size();
+
+				values.resize(done + count);
+
+				if (!is.read(reinterpret_cast<char *>(values.data() + done), std::streamsize(count * sizeof(T))))
+					return false;
+
+				left -= count;
+			}
+
+			break;
+
+		case uint8_t(SnapshotFormat::DeltaPacked):
+			if constexpr(isPackable_<T>){
+				values.reserve(size_t(std::min<uint64_t>(size, CHUNK)));
+
+				if (!readDeltaPacked_(is, size, values))
+					return false;
+
+				break;
+			}else{
+				return false;
+			}
+
+		default:
+			return false;
+		}
+
+		// do not trust the input, buildBalanced_() needs sorted and unique keys.
+		return std::adjacent_find(std::begin(values), std::end(values), [](T const &a, T const &b){
+			return !(a < b);
+		}) == std::end(values);
+	}
+
+
+
+} // namespace alv_impl_
+
+
+template<typename T>
+class FrozenAVLTree;
+
+template<typename T>
+class DurableAVLTree;
+
+template<typename T, typename Balance = avl_impl_::AVLBalance>
+class AVLMultiset;
+
+template<typename T, typename Balance = avl_impl_::AVLBalance>
+class MerkleAVLTree;
+
+template<typename K, typename V, typename Balance = avl_impl_::AVLBalance>
+class AVLSlabMap;
+
+template<typename T, typename Balance = avl_impl_::AVLBalance>
+class AVLTree{
+	using Node = typename avl_impl_::Node<T>;
+
+	constexpr static bool WEAK = Balance::WEAK;
+
+	Node *root = nullptr;
+
+	// kept up to date, so begin(), min() and max() do not search.
+	Node	*leftmost	= nullptr;
+	Node	*rightmost	= nullptr;
+	size_t	size_		= 0;	// without the lazy erased nodes
+
+	// lazy erase, see set_lazy_erase()
+	size_t	dead_		= 0;
+	double	lazyErase	= 0;
+
+	// nodes made by relayout(), destroyed in place.
+	// the block is freed together with its last node.
+	Node	*block		= nullptr;
+	size_t	blockSize	= 0;
+	size_t	blockLive	= 0;
+
+	// exact find() by hash, see set_hash_index()
+	avl_impl_::HashIndex<T>	index;
+
+	// hot keys of exact find(), see set_front_cache().
+	// owned, a pointer, so const find() can update it.
+	avl_impl_::FrontCache<T> *cache = nullptr;
+
+	// absent keys of exact find(), see set_bloom_filter(), owned
+	avl_impl_::BloomFilter *filter = nullptr;
+
+	friend class FrozenAVLTree<T>;
+	friend class DurableAVLTree<T>;
+	template<typename, typename>
+	friend class AVLMultiset;
+	template<typename, typename>
+	friend class MerkleAVLTree;
+	template<typename, typename, typename>
+	friend class AVLSlabMap;
+
+public:
+	constexpr AVLTree() = default;
+
+	AVL_CONSTEXPR_20 ~AVLTree(){
+		// the nodes do not need to leave the index one by one.
+		index.disable();
+
+		delete cache;
+		cache = nullptr;
+
+		delete filter;
+		filter = nullptr;
+
+		deallocateTree_(root);
+	}
+
+	// copy is O(n) allocations, so it is explicit, see clone().
+	AVLTree(AVLTree const &) = delete;
+	AVLTree &operator =(AVLTree const &) = delete;
+
+	AVL_CONSTEXPR_20 AVLTree(AVLTree &&other){
+		swap_(other);
+	}
+
+	AVL_CONSTEXPR_20 AVLTree &operator =(AVLTree &&other){
+		swap_(other);
+		return *this;
+	}
+
+	AVLTree clone() const{
+		// same shape, balance and lazy erased nodes, no comparisons, O(n).
+		// the nodes go in one block in pre-order,
+		// so the copy has better locality than a tree made by inserts.
+
+		AVLTree tree;
+
+		tree.lazyErase = lazyErase;
+
+		size_t const size = size_ + dead_;
+
+		if (!size)
+			return tree;
+
+		Node *next = std::allocator<Node>{}.allocate(size);
+
+		tree.block	= next;
+		tree.blockSize	= size;
+		tree.blockLive	= size;
+
+		tree.root	= cloneTree__(root, nullptr, next);
+		tree.leftmost	= avl_impl_::minValueNode(tree.root);
+		tree.rightmost	= avl_impl_::maxValueNode(tree.root);
+		tree.size_	= size_;
+		tree.dead_	= dead_;
+
+		if constexpr(avl_impl_::isHashable_<T>){
+			if (index.enabled())
+				tree.set_hash_index(true);
+
+			if (cache)
+				tree.set_front_cache(cache->size());
+
+			if (filter)
+				tree.set_bloom_filter(filter->bitsPerKey);
+		}
+
+		return tree;
+	}
+
+private:
+	AVL_CONSTEXPR_20 void swap_(AVLTree &other){
+		using std::swap;
+
+		swap(root	, other.root		);
+		swap(leftmost	, other.leftmost	);
+		swap(rightmost	, other.rightmost	);
+		swap(size_	, other.size_		);
+		swap(dead_	, other.dead_		);
+		swap(lazyErase	, other.lazyErase	);
+		swap(block	, other.block		);
+		swap(blockSize	, other.blockSize	);
+		swap(blockLive	, other.blockLive	);
+		swap(index	, other.index		);
+		swap(cache	, other.cache		);
+		swap(filter	, other.filter		);
+	}
+
+	static Node *cloneTree__(const Node *node, Node *parent, Node *&next){
+		if (!node)
+			return nullptr;
+
+		auto *copy = new (next++) Node(node->data, parent);
+
+		copy->balance	= node->balance;
+		copy->dead	= node->dead;
+		copy->l		= cloneTree__(node->l, copy, next);
+		copy->r		= cloneTree__(node->r, copy, next);
+
+		return copy;
+	}
+
+public:
+	using iterator = avl_impl_::iterator<T>;
+
+public:
+	void printPretty() const{
+		return avl_impl_::printPretty(root);
+	}
+
+	void check() const{
+		if constexpr(WEAK)
+			return avl_impl_::checkWeak(root);
+		else
+			return avl_impl_::check(root);
+	}
+
+public:
+	AVL_CONSTEXPR_20 void clear(){
+		if (index.enabled())
+			index.assign(0);
+
+		if (cache)
+			cache->clear();
+
+		deallocateTree_(root);
+		root		= nullptr;
+		leftmost	= nullptr;
+		rightmost	= nullptr;
+		size_		= 0;
+		dead_		= 0;
+
+		// after the nodes, they are counted as erased in the old filter.
+		if constexpr(avl_impl_::isHashable_<T>)
+			if (filter)
+				refilter__(0);
+	}
+
+	constexpr size_t size() const{
+		return size_;
+	}
+
+	constexpr bool empty() const{
+		return size_ == 0;
+	}
+
+	template<typename UT>
+	AVL_CONSTEXPR_20 iterator insert(UT &&data){
+		return insert__(data, [&data](Node *parent){
+			return allocateNode__(std::forward<UT>(data), parent);
+		}, [&data](Node *node){
+			node->data = T(std::forward<UT>(data));
+		});
+	}
+
+private:
+	template<typename UT, typename F, typename R>
+	AVL_CONSTEXPR_20 iterator insert__(UT const &data, F &&makeNode, R &&reviveNode){
+		// make(parent) is called once the key is known to be new.
+		// reviveNode(node) puts data in a lazy erased node with the same key.
+
+		auto make = [&](Node *parent){
+			auto *node = makeNode(parent);
+			index__(node);
+			return node;
+		};
+
+		if (!root){
+			// tree is empty.
+			// insert, no balance.
+
+			root = make(nullptr);
+
+			leftmost	= root;
+			rightmost	= root;
+			size_		= 1;
+
+			return root;
+		}
+
+		if constexpr(avl_impl_::isBranchless_<T, std::decay_t<UT> >){
+			// the children are picked from an array by the comparison,
+			// equality is checked once at the end.
+
+			Node *node	= root;
+			Node *parent	= nullptr;
+			Node *ge	= nullptr;	// last node not less than data
+			bool left	= false;
+
+			while(node){
+				Node *const kids[2] = { node->r, node->l };
+
+				left	= !(node->data < data);
+				ge	= left ? node : ge;
+				parent	= node;
+				node	= kids[left];
+			}
+
+			if (ge && !(data < ge->data))
+				return revive__(ge, reviveNode);
+
+			auto *new_node = make(parent);
+			avl_impl_::link_<WEAK>(root, parent, new_node, left);
+
+			if ( left && parent == leftmost)
+				leftmost = new_node;
+
+			if (!left && parent == rightmost)
+				rightmost = new_node;
+
+			++size_;
+
+			return new_node;
+		}
+
+		auto const prefix = avl_impl_::keyPrefixOf_<T>(data);
+
+		Node *node   = root;
+
+		while(true){
+			auto const c = avl_impl_::compare_(data, prefix, node);
+
+			if (c < 0){
+				if (!node->l){
+					auto *new_node = make(node);
+					avl_impl_::link_<WEAK>(root, node, new_node, true);
+
+					if (node == leftmost)
+						leftmost = new_node;
+
+					++size_;
+
+					return new_node;
+				}else{
+					node = node->l;
+					continue;
+				}
+			}
+
+			if (c > 0){
+				if (!node->r){
+					auto *new_node = make(node);
+					avl_impl_::link_<WEAK>(root, node, new_node, false);
+
+					if (node == rightmost)
+						rightmost = new_node;
+
+					++size_;
+
+					return new_node;
+				}else{
+					node = node->r;
+					continue;
+				}
+			}
+
+			if (c == 0)
+				return revive__(node, reviveNode);
+		}
+
+		// never reach here.
+	}
+
+	AVL_CONSTEXPR_20 void index__(Node *node){
+		// the new node, not linked yet, goes in the hash index and the filter.
+
+		if constexpr(avl_impl_::isHashable_<T>){
+			if (index.enabled())
+				index.insert(node);
+
+			if (filter){
+				if (filter->stale())
+					refilter__(size_ + dead_);
+
+				filter->insert(avl_impl_::hashKey_<T>(node->data));
+			}
+		}
+	}
+
+	AVL_CONSTEXPR_20 void unindex__(const Node *node){
+		// the node leaves the hash index and the front cache,
+		// the filter only counts it.
+
+		if constexpr(avl_impl_::isHashable_<T>){
+			if (index.enabled())
+				index.erase(node);
+
+			if (cache)
+				cache->erase(node);
+
+			if (filter)
+				++filter->erased;
+		}
+	}
+
+	void reindex__(){
+		// after the nodes are moved or rebuilt, the lazy erased are in the index too.
+
+		index.assign(size_ + dead_);
+
+		for(auto *node = avl_impl_::minValueNode(root); node; node = avl_impl_::nextNode_(node))
+			index.insert(node);
+	}
+
+	void refilter__(size_t const count){
+		// new filter for count keys, the lazy erased are in it too, O(n).
+
+		auto *fresh = new avl_impl_::BloomFilter(filter->bitsPerKey, count);
+
+		delete std::exchange(filter, fresh);
+
+		for(auto *node = avl_impl_::minValueNode(root); node && count; node = avl_impl_::nextNode_(node))
+			filter->insert(avl_impl_::hashKey_<T>(node->data));
+	}
+
+	template<typename R>
+	AVL_CONSTEXPR_20 iterator revive__(Node *node, R &reviveNode){
+		if (node->dead){
+			// lazy erased, bring it back with the new data,
+			// the key is the same, so the prefix and the index stay.
+			node->dead = false;
+			--dead_;
+			++size_;
+
+			reviveNode(node);
+
+			// same hash, the new data has no subtree sum yet.
+			avl_impl_::augment_(node);
+
+			return node;
+		}
+
+		if constexpr(avl_impl_::isCounted_<T>){
+			// AVLMultiset, one more copy, no allocation.
+			++node->data.count;
+			return node;
+		}
+
+		// found, not insert, no balance.
+		return end();
+	}
+
+public:
+
+	template<typename UT>
+	AVL_CONSTEXPR_20 bool erase(UT const &key){
+		auto const prefix = avl_impl_::keyPrefixOf_<T>(key);
+
+		auto *node = root;
+
+		while(node){
+			auto const c = avl_impl_::compare_(key, prefix, node);
+
+			if (c < 0){
+				node = node->l;
+				continue;
+			}
+
+			if (c > 0){
+				node = node->r;
+				continue;
+			}
+
+			break;
+		}
+
+		if (!node)
+			return false;
+
+		if (node->dead)
+			return false;
+
+		if (lazyErase > 0){
+			// mark only, no unlink, no balance.
+			node->dead = true;
+			++dead_;
+			--size_;
+
+			if (double(dead_) > lazyErase * double(dead_ + size_))
+				compact();
+
+			return true;
+		}
+
+		unlinkNode__(node);
+
+		deallocateNode_(node);
+
+		return true;
+	}
+
+private:
+	AVL_CONSTEXPR_20 void unlinkNode__(Node *node){
+		if (node == leftmost)
+			leftmost = avl_impl_::nextNode_(node);
+
+		if (node == rightmost)
+			rightmost = avl_impl_::prevNode_(node);
+
+		avl_impl_::unlink_<WEAK>(root, node);
+
+		if (node->dead)
+			--dead_;
+		else
+			--size_;
+	}
+
+public:
+	class node_type{
+		// owns a node taken out by extract(), std::set style.
+
+		Node *node = nullptr;
+
+		friend class AVLTree;
+
+		explicit node_type(Node *node) : node(node){}
+
+	public:
+		node_type() = default;
+
+		node_type(node_type &&other) : node(std::exchange(other.node, nullptr)){}
+
+		node_type &operator =(node_type &&other){
+			std::swap(node, other.node);
+			return *this;
+		}
+
+		~node_type(){
+			delete node;
+		}
+
+		bool empty() const{
+			return !node;
+		}
+
+		explicit operator bool() const{
+			return node;
+		}
+
+		T &value() const{
+			return node->data;
+		}
+	};
+
+	template<typename UT>
+	node_type extract(UT const &key){
+		auto const it = find(key, std::true_type{});
+
+		if (it == end())
+			return {};
+
+		return extract(it);
+	}
+
+	node_type extract(iterator const it){
+		// it must not be end().
+		// the node is unlinked, not freed, so the key is not copied,
+		// except for nodes in a block, see relayout().
+
+		auto *node = const_cast<Node *>(it.node_());
+
+		unindex__(node);
+
+		unlinkNode__(node);
+
+		if (inBlock_(node)){
+			// the block can not give away a node.
+			// the filter counted the key above, not again.
+			auto *copy = allocateNode__(std::move(node->data), nullptr);
+
+			auto *kept = std::exchange(filter, nullptr);
+			deallocateNode_(node);
+			filter = kept;
+
+			node = copy;
+		}
+
+		return node_type{ node };
+	}
+
+	iterator insert(node_type &&handle){
+		// the node is linked, no allocation.
+		// if the key is in the tree, handle keeps the node and end() is returned.
+
+		if (!handle)
+			return end();
+
+		bool revived = false;
+
+		auto const it = insert__(handle.node->data, [&handle](Node *parent){
+			return adopt__(handle, parent);
+		}, [&handle, &revived](Node *node){
+			node->data = std::move(handle.node->data);
+			revived = true;
+		});
+
+		if (it != end() && handle){
+			// the key was lazy erased here and got the data above,
+			// or AVLMultiset counted it, the node in handle is not needed.
+			if constexpr(avl_impl_::isCounted_<T>)
+				if (!revived)
+					it->count += handle.value().count - 1;
+
+			handle = {};
+		}
+
+		return it;
+	}
+
+	void merge(AVLTree &other){
+		// moves the keys of other that are not here, std::set::merge style.
+		// nodes are relinked, keys are not copied, see extract().
+
+		if (&other == this)
+			return;
+
+		for(Node *node = other.leftmost; node;){
+			auto *next = avl_impl_::nextNode_(node);
+
+			if (!node->dead){
+				bool moved = false;
+
+				auto const it = insert__(node->data, [&](Node *parent){
+					moved = true;
+
+					auto handle = other.extract(iterator{ node });
+					return adopt__(handle, parent);
+				}, [&](Node *dead){
+					// lazy erased here, it gets the data of other.
+					moved = true;
+
+					auto handle = other.extract(iterator{ node });
+					dead->data = std::move(handle.value());
+				});
+
+				// brought back or counted here, so it leaves other.
+				if (it != end() && !moved){
+					if constexpr(avl_impl_::isCounted_<T>)
+						it->count += node->data.count - 1;
+
+					other.extract(iterator{ node });
+				}
+			}
+
+			node = next;
+		}
+	}
+
+private:
+	static Node *adopt__(node_type &handle, Node *parent){
+		auto *node = std::exchange(handle.node, nullptr);
+
+		// value() may have changed the key
+		node->prefix	= avl_impl_::keyPrefixOf_<T>(node->data);
+
+		node->balance	= 0;
+		node->dead	= false;
+		node->l		= nullptr;
+		node->r		= nullptr;
+		node->p		= parent;
+
+		return node;
+	}
+
+public:
+	template<typename UT>
+	size_t erase_below(UT const &key){
+		// erase keys < key, returns the count.
+		// O(log n) to detach, O(k) to deallocate.
+
+		if constexpr(WEAK)
+			return eraseRun__(leftmost, [&key](T const &x){
+				return key > x;
+			}, true);
+
+		Node	*l, *r;
+		size_t	hl, hr;
+
+		split__([&key](T const &x){
+			return key > x;
+		}, l, hl, r, hr);
+
+		return replace__(r, l);
+	}
+
+	template<typename UT>
+	size_t erase_above(UT const &key){
+		// erase keys > key, returns the count.
+
+		if constexpr(WEAK)
+			return eraseRun__(rightmost, [&key](T const &x){
+				return key < x;
+			}, false);
+
+		Node	*l, *r;
+		size_t	hl, hr;
+
+		split__([&key](T const &x){
+			return !(key < x);
+		}, l, hl, r, hr);
+
+		return replace__(l, r);
+	}
+
+	template<typename UT>
+	size_t erase_range(UT const &first, UT const &last){
+		// erase keys in [first, last), returns the count.
+
+		if (!(first < last))
+			return 0;
+
+		if constexpr(WEAK)
+			return eraseRun__(const_cast<Node *>(find(first, std::false_type{}).node_()), [&last](T const &x){
+				return last > x;
+			}, true);
+
+		Node	*l, *m, *r;
+		size_t	hl, hm, hr;
+
+		split__([&first](T const &x){
+			return first > x;
+		}, l, hl, r, hr);
+
+		auto goesLeft = [&last](T const &x){
+			return last > x;
+		};
+
+		avl_impl_::split_(r, hr, goesLeft, m, hm, r, hr);
+
+		return replace__(avl_impl_::join_(l, r, hl, hr), m);
+	}
+
+	template<typename F>
+	size_t erase_if(F &&pred){
+		// erase keys where pred(key) is true, returns the count.
+		// the others are relinked into a balanced tree, not reallocated, O(n).
+
+		auto const size = size_;
+
+		rebuild_(pred);
+
+		return size - size_;
+	}
+
+private:
+	template<typename F>
+	void rebuild_(F &&pred){
+		// lazy erased nodes are dropped too.
+
+		Node *keep	= nullptr;	// in order, linked by r
+		Node *keepTail	= nullptr;
+		Node *drop	= nullptr;	// linked by r
+
+		size_t keepSize = 0;
+
+		for(auto *node = leftmost; node;){
+			// next first, r is overwritten below.
+			// l and p are not changed until the rebuild.
+			auto *next = avl_impl_::nextNode_(node);
+
+			if (node->dead || pred(std::as_const(node->data))){
+				node->r = drop;
+				drop = node;
+			}else{
+				node->r = nullptr;
+
+				if (keepTail)
+					keepTail->r = node;
+				else
+					keep = node;
+
+				keepTail = node;
+				++keepSize;
+			}
+
+			node = next;
+		}
+
+		while(drop){
+			auto *next = drop->r;
+			deallocateNode_(drop);
+			drop = next;
+		}
+
+		root = avl_impl_::buildBalanced_<T, WEAK>(keepSize, nullptr, [&keep](){
+			auto *node = keep;
+			keep = keep->r;
+			return node;
+		});
+
+		leftmost	= avl_impl_::minValueNode(root);
+		rightmost	= avl_impl_::maxValueNode(root);
+		size_		= keepSize;
+		dead_		= 0;
+	}
+
+	template<typename F>
+	size_t eraseRun__(Node *node, F inRange, bool const forward){
+		// WAVLBalance - the ranks do not give the heights split_() and join_() need,
+		// so the keys are erased one by one, O(k) amortized.
+
+		size_t count = 0;
+
+		while(node && inRange(std::as_const(node->data))){
+			auto *next = forward ? avl_impl_::nextNode_(node) : avl_impl_::prevNode_(node);
+
+			if (!node->dead)
+				++count;
+
+			unlinkNode__(node);
+			deallocateNode_(node);
+
+			node = next;
+		}
+
+		return count;
+	}
+
+	constexpr static size_t height__(const Node *node){
+		if constexpr(WEAK)
+			return size_t(avl_impl_::rank_(node) + 1);
+		else
+			return avl_impl_::height_(node);
+	}
+
+	template<typename F>
+	void split__(F goesLeft, Node *&l, size_t &hl, Node *&r, size_t &hr){
+		avl_impl_::split_(root, avl_impl_::height_(root), goesLeft, l, hl, r, hr);
+	}
+
+	size_t replace__(Node *keep, Node *drop){
+		root		= keep;
+		leftmost	= avl_impl_::minValueNode(root);
+		rightmost	= avl_impl_::maxValueNode(root);
+
+		auto const count = deallocateTree_(drop);
+
+		size_ -= count;
+
+		return count;
+	}
+
+public:
+	void set_hash_index(bool const enable){
+		// exact find() looks up the node in a hash table, O(1), 1-2 cache misses.
+		// the other lookups, ranges and iteration still go through the tree.
+		// insert and erase keep it up to date, 21 - 43 bytes per key.
+
+		static_assert(avl_impl_::isHashable_<T>, "std::hash<T> is needed");
+
+		if (!enable)
+			return index.disable();
+
+		reindex__();
+	}
+
+	bool hash_index() const{
+		return index.enabled();
+	}
+
+	void set_front_cache(size_t const slots){
+		// exact find() checks slots (rounded to a power of 2) recently found keys first,
+		// a hit costs a hash and one key compare, 16 bytes per slot.
+		// 0 turns it off. find() updates the cache,
+		// so with the cache on, concurrent find() calls are not safe.
+
+		static_assert(avl_impl_::isHashable_<T>, "std::hash<T> is needed");
+
+		delete cache;
+		cache = slots ? new avl_impl_::FrontCache<T>(slots) : nullptr;
+	}
+
+	avl_impl_::FrontCacheStats front_cache_stats() const{
+		return cache ? cache->stats : avl_impl_::FrontCacheStats{};
+	}
+
+	void set_bloom_filter(size_t const bitsPerKey){
+		// exact find() of an absent key returns end() without the descent,
+		// except for the false positives, about 1% with 10 bits per key.
+		// 0 turns it off.
+		// erase can not clear bits, so insert rebuilds the filter
+		// when it has too many keys or too many erased keys, O(1) amortized.
+
+		static_assert(avl_impl_::isHashable_<T>, "std::hash<T> is needed");
+
+		delete filter;
+		filter = nullptr;
+
+		if (!bitsPerKey)
+			return;
+
+		filter = new avl_impl_::BloomFilter(bitsPerKey, 0);
+
+		refilter__(size_ + dead_);
+	}
+
+	size_t bloom_filter_bytes() const{
+		return filter ? filter->bytes() : 0;
+	}
+
+public:
+	void set_lazy_erase(double const fraction){
+		// fraction == 0 - erase unlinks the node.
+		// fraction  > 0 - erase marks the node dead, find and iteration skip it.
+		//                 when dead nodes are more than fraction of all nodes,
+		//                 the tree is rebuilt without them in O(n).
+
+		lazyErase = fraction;
+
+		if (lazyErase <= 0 && dead_)
+			compact();
+	}
+
+	constexpr size_t dead() const{
+		return dead_;
+	}
+
+	void compact(){
+		// remove the lazy erased nodes
+		rebuild_([](T const &){
+			return false;
+		});
+	}
+
+public:
+	// double-ended priority queue
+
+	constexpr iterator min() const{
+		return begin();
+	}
+
+	constexpr iterator max() const{
+		const Node *node = rightmost;
+
+		while(node && node->dead)
+			node = avl_impl_::prevNode_(node);
+
+		return node;
+	}
+
+	AVL_CONSTEXPR_20 bool pop_min(){
+		while(leftmost && leftmost->dead)
+			popMin__();
+
+		if (!leftmost)
+			return false;
+
+		popMin__();
+
+		return true;
+	}
+
+	AVL_CONSTEXPR_20 bool pop_max(){
+		while(rightmost && rightmost->dead)
+			popMax__();
+
+		if (!rightmost)
+			return false;
+
+		popMax__();
+
+		return true;
+	}
+
+private:
+	AVL_CONSTEXPR_20 void popMin__(){
+		// leftmost has no left child,
+		// so its right child is a leaf and becomes the next leftmost.
+
+		auto *node	= leftmost;
+		auto *child	= node->r;
+		auto *parent	= node->p;
+
+		leftmost = child ? child : parent;
+
+		if (node == rightmost)
+			rightmost = nullptr;
+
+		popLeaf__(node, child, true);
+	}
+
+	AVL_CONSTEXPR_20 void popMax__(){
+		// mirror of popMin__()
+
+		auto *node	= rightmost;
+		auto *child	= node->l;
+		auto *parent	= node->p;
+
+		rightmost = child ? child : parent;
+
+		if (node == leftmost)
+			leftmost = nullptr;
+
+		popLeaf__(node, child, false);
+	}
+
+	AVL_CONSTEXPR_20 void popLeaf__(Node *node, Node *child, bool const left){
+		// the node has no child on the left / right side, no search, no successor.
+
+		auto *parent = node->p;
+
+		if (child)
+			child->p = parent;
+
+		if (!parent){
+			root = child;
+		}else{
+			if (left)
+				parent->l = child;
+			else
+				parent->r = child;
+
+			avl_impl_::augmentUp_(parent);
+			avl_impl_::shorter_<WEAK>(root, parent, left);
+		}
+
+		if (node->dead)
+			--dead_;
+		else
+			--size_;
+
+		deallocateNode_(node);
+	}
+
+public:
+	constexpr static auto SNAPSHOT_FORMAT = avl_impl_::isPackable_<T> ?
+						avl_impl_::SnapshotFormat::DeltaPacked :
+						avl_impl_::SnapshotFormat::Raw;
+
+	void save(std::ostream &os, avl_impl_::SnapshotFormat const format = SNAPSHOT_FORMAT) const{
+		return avl_impl_::saveSnapshot<T>(os, begin(), size(), format);
+	}
+
+	bool load(std::istream &is){
+		// on error, the tree is not changed.
+
+		std::vector<T> values;
+
+		if (!avl_impl_::loadSnapshot(is, values))
+			return false;
+
+		clear();
+
+		assignSorted_(std::make_move_iterator(std::begin(values)), values.size());
+
+		return true;
+	}
+
+public:
+	void relayout(){
+		// moves all nodes into one block in van Emde Boas order,
+		// so the top levels of every descent share cache lines.
+		// contents, iterators order and the API are not changed,
+		// but the old iterators are invalidated.
+
+		std::vector<Node *> order;
+
+		avl_impl_::vebOrder_(root, height__(root), order);
+
+		if (order.empty())
+			return;
+
+		size_t const size = order.size();
+
+		Node *newBlock = std::allocator<Node>{}.allocate(size);
+
+		for(size_t i = 0; i < size; ++i)
+			new (newBlock + i) Node(std::move(*order[i]));
+
+		// the old p now points to the new node.
+		// the new nodes still link to the old ones.
+
+		for(size_t i = 0; i < size; ++i)
+			order[i]->p = newBlock + i;
+
+		auto _ = [](Node *old){
+			return old ? old->p : nullptr;
+		};
+
+		for(size_t i = 0; i < size; ++i){
+			auto &node = newBlock[i];
+
+			node.l = _(node.l);
+			node.r = _(node.r);
+			node.p = _(node.p);
+		}
+
+		root		= _(root);
+		leftmost	= _(leftmost);
+		rightmost	= _(rightmost);
+
+		// the old keys are moved out, they can not be found in the index.
+		// the keys are not erased, the filter does not count them.
+		bool const indexed = index.enabled();
+		index.disable();
+
+		auto *kept = std::exchange(filter, nullptr);
+
+		for(auto *old : order)
+			deallocateNode_(old);
+
+		filter = kept;
+
+		assert(!block);
+
+		block		= newBlock;
+		blockSize	= size;
+		blockLive	= size;
+
+		if constexpr(avl_impl_::isHashable_<T>)
+			if (indexed)
+				reindex__();
+
+		if (cache)
+			cache->clear();
+	}
+
+public:
+	template<typename It>
+	void build_parallel(It first, It last, unsigned threads = std::thread::hardware_concurrency()){
+		// replaces the contents with the keys from [first, last), in any order.
+		// sort and build run on up to threads threads.
+		// all nodes go in one block, each thread fills its own slice.
+
+		threads = std::max(threads, 1u);
+
+		std::vector<T> values(first, last);
+
+		avl_impl_::parallelSort_(values.data(), values.size(), threads);
+
+		values.erase(std::unique(std::begin(values), std::end(values), [](T const &a, T const &b){
+			return !(a < b);
+		}), std::end(values));
+
+		clear();
+
+		if (values.empty())
+			return;
+
+		assert(!block);
+
+		size_t const size = values.size();
+
+		block		= std::allocator<Node>{}.allocate(size);
+		blockSize	= size;
+		blockLive	= size;
+
+		root		= avl_impl_::buildParallel_<T, WEAK>(block, values.data(), size, nullptr, threads);
+		leftmost	= block;
+		rightmost	= block + size - 1;
+		size_		= size;
+
+		if constexpr(avl_impl_::isHashable_<T>){
+			if (index.enabled())
+				reindex__();
+
+			if (filter)
+				refilter__(size_);
+		}
+	}
+
+public:
+	template<typename F>
+	void parallel_for_each(F &&f, unsigned const threads = std::thread::hardware_concurrency()) const{
+		// f(key) for every key, on up to threads threads, in no order.
+		// the top subtrees go to separate threads,
+		// each one walks its subtree in order.
+
+		forEach__(root, size_ + dead_, f, std::max(threads, 1u));
+	}
+
+	template<typename R, typename Map, typename Combine>
+	R parallel_reduce(R const &identity, Map &&map, Combine &&combine, unsigned const threads = std::thread::hardware_concurrency()) const{
+		// combine(map(key)...) on up to threads threads.
+		// results are combined in key order,
+		// so combine must be associative, but not commutative.
+
+		return reduce__(root, size_ + dead_, identity, map, combine, std::max(threads, 1u));
+	}
+
+private:
+	// size is the node count of the subtree, about.
+	// it is not stored, the children get half each, close enough for the top levels.
+
+	template<typename F>
+	static void forEach__(const Node *node, size_t const size, F &f, unsigned const threads){
+		if (!node)
+			return;
+
+		if (threads < 2 || size < avl_impl_::PARALLEL_MIN_SIZE){
+			// in order, nextNode_() does not leave the subtree before its last node.
+
+			const Node *last = avl_impl_::maxValueNode(node);
+
+			for(const Node *it = avl_impl_::minValueNode(node);; it = avl_impl_::nextNode_(it)){
+				if (!it->dead)
+					f(std::as_const(it->data));
+
+				if (it == last)
+					return;
+			}
+		}
+
+		avl_impl_::forkJoin_(threads,
+			[&](){ forEach__(node->l, size / 2, f, threads / 2); },
+			[&](){
+				if (!node->dead)
+					f(std::as_const(node->data));
+
+				forEach__(node->r, size / 2, f, threads - threads / 2);
+			}
+		);
+	}
+
+	template<typename R, typename Map, typename Combine>
+	static R reduce__(const Node *node, size_t const size, R const &identity, Map &map, Combine &combine, unsigned const threads){
+		if (!node)
+			return identity;
+
+		if (threads < 2 || size < avl_impl_::PARALLEL_MIN_SIZE){
+			// left to right fold, one combine per key.
+
+			R acc = identity;
+
+			auto fold = [&](T const &key){
+				acc = combine(std::move(acc), map(key));
+			};
+
+			forEach__(node, size, fold, 1);
+
+			return acc;
+		}
+
+		R l = identity;
+		R r = identity;
+
+		avl_impl_::forkJoin_(threads,
+			[&](){ l = reduce__(node->l, size / 2, identity, map, combine, threads / 2); },
+			[&](){ r = reduce__(node->r, size / 2, identity, map, combine, threads - threads / 2); }
+		);
+
+		if (node->dead)
+			return combine(std::move(l), std::move(r));
+
+		return combine(std::move(l), combine(map(std::as_const(node->data)), std::move(r)));
+	}
+
+public:
+	FrozenAVLTree<T> freeze() const{
+		return { begin(), size() };
+	}
+
+public:
+	template<bool Exact, typename UT>
+	constexpr iterator find(UT const &key, std::bool_constant<Exact> exact) const{
+		if constexpr(Exact && avl_impl_::isHashLookup_<T, UT>)
+			if (filter || cache)
+				return findHashed__(key);
+
+		return find__(key, exact);
+	}
+
+private:
+	template<typename UT>
+	iterator findHashed__(UT const &key) const{
+		// the Bloom filter, then the front cache, then the hash index or the tree.
+
+		auto const hash = avl_impl_::hashKey_<T>(key);
+
+		if (filter && !filter->mayContain(hash))
+			return end();
+
+		if (!cache)
+			return find__(key, std::true_type{});
+
+		if (auto *node = cache->find(key, hash))
+			return result__<true>(node);
+
+		auto const it = find__(key, std::true_type{});
+
+		if (it != end())
+			cache->store(hash, it.node_());
+
+		return it;
+	}
+
+	template<bool Exact, typename UT>
+	constexpr iterator find__(UT const &key, std::bool_constant<Exact>) const{
+		if constexpr(Exact && avl_impl_::isHashLookup_<T, UT>)
+			if (index.enabled())
+				return result__<true>(index.find(key));
+
+		if constexpr(avl_impl_::isBranchless_<T, UT>){
+			// lower bound, then equality once at the end.
+
+			const Node *node	= root;
+			const Node *ge		= nullptr;
+
+			while(node){
+				const Node *const kids[2] = { node->r, node->l };
+
+				bool const left = !(node->data < key);
+
+				ge	= left ? node : ge;
+				node	= kids[left];
+			}
+
+			if constexpr(Exact)
+				if (ge && key < ge->data)
+					ge = nullptr;
+
+			return result__<Exact>(ge);
+		}
+
+		auto const prefix = avl_impl_::keyPrefixOf_<T>(key);
+
+		auto *node = root;
+
+		while(node){
+			auto const c = avl_impl_::compare_(key, prefix, node);
+
+			if (c < 0){
+				if constexpr(!Exact)
+					if (node->l == nullptr)
+						return result__<false>(findFix__(node, key));
+
+				node = node->l;
+				continue;
+			}
+
+			if (c > 0){
+				if constexpr(!Exact)
+					if (node->r == nullptr)
+						return result__<false>(findFix__(node, key));
+
+				node = node->r;
+				continue;
+			}
+
+			break;
+		}
+
+		return result__<Exact>(node);
+	}
+
+public:
+	constexpr static size_t FIND_MANY_GROUP = 16;
+
+	template<bool Exact, typename It, typename OutIt>
+	OutIt find_many(It first, It last, OutIt out, std::bool_constant<Exact> exact) const{
+		// same as find() for each key, results are written to out in key order.
+		// FIND_MANY_GROUP lookups go down together, one level per round.
+		// each round prefetches the next node of every lookup,
+		// so the cache misses of the group overlap instead of adding up.
+
+		using Key	= typename std::iterator_traits<It>::value_type;
+		using Category	= typename std::iterator_traits<It>::iterator_category;
+
+		constexpr size_t G = FIND_MANY_GROUP;
+
+		if constexpr(!std::is_base_of_v<std::forward_iterator_tag, Category>){
+			// input iterator, *first is gone after ++first,
+			// so the keys of each group are copied.
+
+			std::vector<Key> group;
+			group.reserve(G);
+
+			while(first != last){
+				group.clear();
+
+				for(; group.size() < G && first != last; ++first)
+					group.push_back(*first);
+
+				out = find_many(std::begin(group), std::end(group), out, exact);
+			}
+
+			return out;
+		}
+
+		while(first != last){
+			using Prefix = decltype(avl_impl_::keyPrefixOf_<T>(std::declval<Key const &>()));
+
+			const Key	*keys[G];
+			Prefix		prefixes[G];
+			const Node	*nodes[G];
+			const Node	*results[G];
+
+			size_t g = 0;
+
+			for(; g < G && first != last; ++g, ++first){
+				keys[g]		= std::addressof(*first);
+				prefixes[g]	= avl_impl_::keyPrefixOf_<T>(*keys[g]);
+				nodes[g]	= root;
+				results[g]	= nullptr;
+			}
+
+			for(size_t active = root ? g : 0; active;){
+				for(size_t i = 0; i < g; ++i){
+					const auto *node = nodes[i];
+
+					if (!node)
+						continue;
+
+					auto const &key = *keys[i];
+
+					const Node *next = nullptr;
+
+					auto const c = avl_impl_::compare_(key, prefixes[i], node);
+
+					if (c < 0){
+						next = node->l;
+
+						if constexpr(!Exact)
+							if (!next)
+								results[i] = findFix__(node, key);
+					}else if (c > 0){
+						next = node->r;
+
+						if constexpr(!Exact)
+							if (!next)
+								results[i] = findFix__(node, key);
+					}else{
+						results[i] = node;
+					}
+
+					nodes[i] = next;
+
+					if (next)
+						avl_impl_::prefetch_(next);
+					else
+						--active;
+				}
+			}
+
+			for(size_t i = 0; i < g; ++i){
+				*out = result__<Exact>(results[i]);
+				++out;
+			}
+		}
+
+		return out;
+	}
+
+	template<typename It, typename F>
+	void find_sorted(It first, It last, F &&f) const{
+		// keys must be sorted, f(key, iterator) is called for each key in order,
+		// with end() when the key is not found.
+		// the tree is walked once, the keys are split at every node,
+		// so k keys cost O(k log(n / k)) instead of O(k log n).
+
+		findSorted__(root, first, last, f);
+	}
+
+	constexpr iterator begin() const{
+		return avl_impl_::liveNode_<const Node>(leftmost);
+	}
+
+	constexpr static iterator end(){
+		return nullptr;
+	}
+
+private:
+	template<typename It, typename F>
+	static void findSorted__(const Node *node, It first, It last, F &f){
+		if (first == last)
+			return;
+
+		if (!node){
+			for(; first != last; ++first)
+				f(*first, end());
+
+			return;
+		}
+
+		auto const lo = std::partition_point(first, last, [node](auto const &key){
+			return key < node->data;
+		});
+
+		auto const hi = std::partition_point(lo, last, [node](auto const &key){
+			return !(key > node->data);
+		});
+
+		findSorted__(node->l, first, lo, f);
+
+		for(auto it = lo; it != hi; ++it)
+			f(*it, result__<true>(node));
+
+		findSorted__(node->r, hi, last, f);
+	}
+
+	template<bool Exact>
+	constexpr static iterator result__(const Node *node){
+		// lazy erased node is not found,
+		// or the next one, if not exact.
+
+		if (node && node->dead){
+			if constexpr(Exact)
+				return end();
+			else
+				return avl_impl_::liveNode_(node);
+		}
+
+		return node;
+	}
+
+	template<typename UT>
+	constexpr static const Node *findFix__(const Node *node, UT const &key){
+		while(node)
+			if (key > node->data)
+				node = node->p;
+			else
+				break;
+
+		return node;
+	}
+
+	template<typename It>
+	AVLTree(It first, size_t const size){
+		assignSorted_(first, size);
+	}
+
+	template<typename It>
+	void assignSorted_(It first, size_t const size){
+		// tree must be empty.
+		// input must be sorted and unique, O(n)
+
+		assert(!root);
+
+		root = avl_impl_::buildBalanced_<T, WEAK>(size, nullptr, [&first](){
+			auto *node = allocateNode__(*first, nullptr);
+			++first;
+			return node;
+		});
+
+		leftmost	= avl_impl_::minValueNode(root);
+		rightmost	= avl_impl_::maxValueNode(root);
+		size_		= size;
+
+		if constexpr(avl_impl_::isHashable_<T>){
+			if (index.enabled())
+				reindex__();
+
+			if (filter)
+				refilter__(size_);
+		}
+	}
+
+	template<typename UT>
+	AVL_CONSTEXPR_20 static Node *allocateNode__(UT &&data, Node *parent){
+		return new Node(std::forward<UT>(data), parent);
+	}
+
+	AVL_CONSTEXPR_20 void deallocateNode_(Node *node){
+		assert(node);
+
+		unindex__(node);
+
+		if (inBlock_(node)){
+			node->~Node();
+
+			if (--blockLive == 0){
+				std::allocator<Node>{}.deallocate(block, blockSize);
+
+				block		= nullptr;
+				blockSize	= 0;
+			}
+
+			return;
+		}
+
+		delete node;
+	}
+
+	constexpr bool inBlock_(const Node *node) const{
+		// std::less, because the node may not be in the block at all.
+		return block && !std::less<const Node *>{}(node, block) && std::less<const Node *>{}(node, block + blockSize);
+	}
+
+private:
+	AVL_CONSTEXPR_20 size_t deallocateTree_(Node *node){
+		// seems there is no viable iterative alternative
+		// returns the count without the lazy erased nodes.
+
+		if (!node)
+			return 0;
+
+		auto *l = node->l;
+		auto *r = node->r;
+
+		size_t const live = node->dead ? 0 : 1;
+
+		dead_ -= 1 - live;
+
+		deallocateNode_(node);
+
+		return deallocateTree_(l) + deallocateTree_(r) + live;
+	}
+
+};
+
+
+
+template<typename T, typename Balance>
+class AVLMultiset{
+	// AVLTree with repeated keys.
+	// equal keys share one node with a count, so the comparisons see the plain key,
+	// insert of a present key does not allocate,
+	// count() and equal_range() are O(log n).
+
+	using Counted	= avl_impl_::Counted<T>;
+	using Tree	= AVLTree<Counted, Balance>;
+	using Node	= typename Tree::Node;
+
+	Tree	tree;
+	size_t	size_	= 0;	// with the copies
+
+public:
+	// iterates the nodes, x.key and x.count
+	using node_iterator = typename Tree::iterator;
+
+	class iterator{
+	public:
+		constexpr iterator(node_iterator it, size_t i = 0) : it(it), i(i){}
+
+	public:
+		using difference_type	= std::ptrdiff_t;
+		using value_type	= const T;
+		using pointer		= value_type *;
+		using reference		= value_type &;
+		using iterator_category	= std::forward_iterator_tag;
+
+	public:
+		constexpr iterator &operator++(){
+			// each key count times, std::multiset style.
+
+			if (++i == it->count){
+				++it;
+				i = 0;
+			}
+
+			return *this;
+		}
+
+		constexpr reference operator*() const{
+			return it->key;
+		}
+
+		constexpr bool operator==(const iterator &other) const{
+			return it == other.it && i == other.i;
+		}
+
+		constexpr bool operator!=(const iterator &other) const{
+			return ! operator==(other);
+		}
+
+		constexpr pointer operator ->() const{
+			return & operator*();
+		}
+
+	private:
+		node_iterator	it;
+		size_t		i;
+	};
+
+public:
+	constexpr AVLMultiset() = default;
+
+	AVLMultiset(AVLMultiset &&other) = default;
+	AVLMultiset &operator =(AVLMultiset &&other) = default;
+
+public:
+	void check() const{
+		tree.check();
+
+		size_t size = 0;
+
+		for(auto const &x : tree){
+			assert(x.count > 0);
+			size += x.count;
+		}
+
+		assert(size == size_);
+	}
+
+	void printPretty() const{
+		return tree.printPretty();
+	}
+
+public:
+	AVL_CONSTEXPR_20 void clear(){
+		tree.clear();
+		size_ = 0;
+	}
+
+	constexpr size_t size() const{
+		return size_;
+	}
+
+	constexpr size_t distinct() const{
+		return tree.size();
+	}
+
+	constexpr bool empty() const{
+		return tree.empty();
+	}
+
+public:
+	template<typename UT>
+	AVL_CONSTEXPR_20 node_iterator insert(UT &&key){
+		// one descent, a present key gets count + 1.
+
+		++size_;
+
+		return tree.insert(std::forward<UT>(key));
+	}
+
+	template<typename UT>
+	AVL_CONSTEXPR_20 bool erase_one(UT const &key){
+		// one copy
+
+		auto const it = tree.find(key, std::true_type{});
+
+		if (it == tree.end())
+			return false;
+
+		--size_;
+
+		if (--it->count == 0)
+			erase__(it);
+
+		return true;
+	}
+
+	template<typename UT>
+	AVL_CONSTEXPR_20 size_t erase(UT const &key){
+		// all copies, returns the count.
+
+		auto const it = tree.find(key, std::true_type{});
+
+		if (it == tree.end())
+			return 0;
+
+		auto const count = it->count;
+
+		size_ -= count;
+
+		erase__(it);
+
+		return count;
+	}
+
+	void merge(AVLMultiset &other){
+		// moves all copies, the counts of equal keys are added.
+		// nodes of new keys are relinked, see AVLTree::merge().
+
+		if (&other == this)
+			return;
+
+		size_ += std::exchange(other.size_, 0);
+
+		tree.merge(other.tree);
+	}
+
+public:
+	template<typename UT>
+	constexpr size_t count(UT const &key) const{
+		auto const it = tree.find(key, std::true_type{});
+
+		return it == tree.end() ? 0 : it->count;
+	}
+
+	template<bool Exact, typename UT>
+	constexpr node_iterator find(UT const &key, std::bool_constant<Exact> exact) const{
+		return tree.find(key, exact);
+	}
+
+	template<typename UT>
+	constexpr std::pair<iterator, iterator> equal_range(UT const &key) const{
+		auto const it = tree.find(key, std::false_type{});
+
+		if (it == tree.end() || key < it->key)
+			return { it, it };
+
+		return { it, std::next(it) };
+	}
+
+public:
+	constexpr iterator begin() const{
+		return tree.begin();
+	}
+
+	constexpr static iterator end(){
+		return Tree::end();
+	}
+
+	// one entry per key, with the count
+	constexpr node_iterator node_begin() const{
+		return tree.begin();
+	}
+
+	constexpr static node_iterator node_end(){
+		return Tree::end();
+	}
+
+private:
+	AVL_CONSTEXPR_20 void erase__(node_iterator const it){
+		// the node is found, no second descent.
+
+		auto *node = const_cast<Node *>(it.node_());
+
+		tree.unlinkNode__(node);
+		tree.deallocateNode_(node);
+	}
+};
+
+
+
+template<typename T, typename Balance>
+class MerkleAVLTree{
+	// AVLTree with the hash sum of every subtree, kept up to date by
+	// the links, rotations and rebalance, O(1) more work per changed node.
+	//
+	// digest(first, last) is the same on every tree with the same keys in [first, last),
+	// so replicas compare key ranges without sending the keys.
+	// diff() walks only the subtrees with different sums,
+	// O(d log^2 n) for d different keys.
+
+	using Merkle	= avl_impl_::Merkle<T>;
+	using Tree	= AVLTree<Merkle, Balance>;
+	using Node	= typename Tree::Node;
+
+	Tree	tree;
+
+public:
+	class iterator{
+	public:
+		constexpr iterator(typename Tree::iterator it) : it(it){}
+
+	public:
+		using difference_type	= std::ptrdiff_t;
+		using value_type	= const T;
+		using pointer		= value_type *;
+		using reference		= value_type &;
+		using iterator_category	= std::forward_iterator_tag;
+
+	public:
+		constexpr iterator &operator++(){
+			++it;
+			return *this;
+		}
+
+		constexpr reference operator*() const{
+			return it->key;
+		}
+
+		constexpr bool operator==(const iterator &other) const{
+			return it == other.it;
+		}
+
+		constexpr bool operator!=(const iterator &other) const{
+			return ! operator==(other);
+		}
+
+		constexpr pointer operator ->() const{
+			return & operator*();
+		}
+
+	private:
+		typename Tree::iterator	it;
+	};
+
+public:
+	MerkleAVLTree() = default;
+
+	MerkleAVLTree(MerkleAVLTree &&other) = default;
+	MerkleAVLTree &operator =(MerkleAVLTree &&other) = default;
+
+public:
+	void check() const{
+		tree.check();
+		check__(tree.root);
+	}
+
+	void printPretty() const{
+		return tree.printPretty();
+	}
+
+public:
+	void clear(){
+		tree.clear();
+	}
+
+	size_t size() const{
+		return tree.size();
+	}
+
+	bool empty() const{
+		return tree.empty();
+	}
+
+public:
+	template<typename UT>
+	iterator insert(UT &&key){
+		return tree.insert(std::forward<UT>(key));
+	}
+
+	template<typename UT>
+	bool erase(UT const &key){
+		return tree.erase(key);
+	}
+
+	template<typename UT>
+	size_t erase_range(UT const &first, UT const &last){
+		return tree.erase_range(first, last);
+	}
+
+	template<bool Exact, typename UT>
+	iterator find(UT const &key, std::bool_constant<Exact> exact) const{
+		return tree.find(key, exact);
+	}
+
+public:
+	iterator begin() const{
+		return tree.begin();
+	}
+
+	static iterator end(){
+		return Tree::end();
+	}
+
+public:
+	uint64_t digest() const{
+		return avl_impl_::subtreeSum_(tree.root);
+	}
+
+	template<typename UT>
+	uint64_t digest(UT const &first, UT const &last) const{
+		// keys in [first, last), O(log n)
+
+		return sumBelow__(tree.root, last, false) - sumBelow__(tree.root, first, false);
+	}
+
+	template<typename It, typename OutIt>
+	OutIt digest_buckets(It first, It last, OutIt out) const{
+		// sorted pivots p0 < p1 < ... < pk split the keys in k + 2 buckets:
+		// [min, p0), [p0, p1), ... [pk, max], O(k log n).
+		// replicas send the buckets, then resync or split only the different ones.
+
+		uint64_t prev = 0;
+
+		for(; first != last; ++first){
+			auto const sum = sumBelow__(tree.root, *first, false);
+
+			*out++ = sum - prev;
+
+			prev = sum;
+		}
+
+		*out++ = digest() - prev;
+
+		return out;
+	}
+
+	template<typename F>
+	void diff(MerkleAVLTree const &other, F &&f) const{
+		// f(key, true) for the keys only here, f(key, false) for the keys only in other,
+		// in key order. f must not change the trees.
+
+		diff__(tree.root, nullptr, nullptr, other, f);
+	}
+
+private:
+	template<typename UT>
+	static uint64_t sumBelow__(const Node *node, UT const &key, bool const inclusive){
+		// keys < key, or <= key
+
+		uint64_t sum = 0;
+
+		while(node){
+			bool const below = inclusive ? !(key < node->data) : node->data < key;
+
+			if (below){
+				sum += avl_impl_::subtreeSum_(node->l) + node->data.hash;
+				node = node->r;
+			}else{
+				node = node->l;
+			}
+		}
+
+		return sum;
+	}
+
+	uint64_t sumBetween__(const T *lo, const T *hi) const{
+		// keys in (lo, hi), nullptr is no bound
+
+		uint64_t const below = hi ? sumBelow__(tree.root, *hi, false) : digest();
+
+		return below - (lo ? sumBelow__(tree.root, *lo, true) : 0);
+	}
+
+	template<typename F>
+	void diff__(const Node *node, const T *lo, const T *hi, MerkleAVLTree const &other, F &f) const{
+		// the node subtree has the keys in (lo, hi)
+
+		if (avl_impl_::subtreeSum_(node) == other.sumBetween__(lo, hi))
+			return;
+
+		if (!node){
+			auto it = lo ? other.tree.find(*lo, std::false_type{}) : other.tree.begin();
+
+			if (lo && it != other.tree.end() && !(*lo < it->key))
+				++it;
+
+			for(; it != other.tree.end() && (!hi || it->key < *hi); ++it)
+				f(it->key, false);
+
+			return;
+		}
+
+		T const &key = node->data.key;
+
+		diff__(node->l, lo, &key, other, f);
+
+		if (other.tree.find(key, std::true_type{}) == other.tree.end())
+			f(key, true);
+
+		diff__(node->r, &key, hi, other, f);
+	}
+
+	static uint64_t check__(const Node *node){
+		// not important, so it stay recursive.
+
+		if (!node)
+			return 0;
+
+		auto const sum = node->data.hash + check__(node->l) + check__(node->r);
+
+		assert(node->data.sum == sum);
+
+		return sum;
+	}
+};
+
+
+
+template<typename K, typename V, typename Balance>
+class AVLSlabMap{
+	// map with the values out of the nodes.
+	// a node has the key, the slot of the value, the links and the balance,
+	// the values are in one vector, the slab, by slot.
+	// a descent reads only small nodes, the value is read once, on a hit.
+	//
+	// V must be default constructible, erase resets the slot to V{}
+	// and the free slots are reused by the next inserts.
+
+	using Slotted	= avl_impl_::Slotted<K>;
+	using Tree	= AVLTree<Slotted, Balance>;
+	using Node	= typename Tree::Node;
+
+	Tree			tree;
+	std::vector<V>		slab;
+	std::vector<uint32_t>	freeSlots;
+
+	template<typename Value>
+	class basic_iterator{
+		using Slab = std::conditional_t<std::is_const_v<Value>, const std::vector<V>, std::vector<V> >;
+
+	public:
+		constexpr basic_iterator(typename Tree::iterator it, Slab *slab) : it(it), slab(slab){}
+
+	public:
+		using difference_type	= std::ptrdiff_t;
+		using value_type	= std::pair<const K &, Value &>;
+		using pointer		= void;
+		using reference		= value_type;
+		using iterator_category	= std::input_iterator_tag;
+
+	public:
+		constexpr basic_iterator &operator++(){
+			++it;
+			return *this;
+		}
+
+		constexpr reference operator*() const{
+			// the value is read here, not on ++.
+
+			return { it->key, (*slab)[it->slot] };
+		}
+
+		constexpr bool operator==(const basic_iterator &other) const{
+			return it == other.it;
+		}
+
+		constexpr bool operator!=(const basic_iterator &other) const{
+			return ! operator==(other);
+		}
+
+	private:
+		typename Tree::iterator	it;
+		Slab			*slab;
+	};
+
+public:
+	// *it is std::pair<const K &, V &>
+	using iterator		= basic_iterator<V>;
+	using const_iterator	= basic_iterator<const V>;
+
+public:
+	AVLSlabMap() = default;
+
+	AVLSlabMap(AVLSlabMap &&other) = default;
+	AVLSlabMap &operator =(AVLSlabMap &&other) = default;
+
+public:
+	void check() const{
+		tree.check();
+
+		assert(tree.size() + freeSlots.size() == slab.size());
+
+		std::vector<bool> used(slab.size());
+
+		for(auto const &x : tree){
+			assert(x.slot < slab.size() && !used[x.slot]);
+			used[x.slot] = true;
+		}
+
+		for(auto const slot : freeSlots){
+			assert(slot < slab.size() && !used[slot]);
+			used[slot] = true;
+		}
+	}
+
+public:
+	void clear(){
+		tree.clear();
+		slab.clear();
+		freeSlots.clear();
+	}
+
+	size_t size() const{
+		return tree.size();
+	}
+
+	bool empty() const{
+		return tree.empty();
+	}
+
+public:
+	template<typename UK, typename UV>
+	std::pair<V *, bool> insert(UK &&key, UV &&value){
+		// a present key keeps its value, std::map::try_emplace style,
+		// key and value are moved only when the key is new.
+
+		if (auto *x = find(key))
+			return { x, false };
+
+		return { &insertNew__(std::forward<UK>(key), std::forward<UV>(value)), true };
+	}
+
+	template<typename UK, typename UV>
+	V &insert_or_assign(UK &&key, UV &&value){
+		// insert() moves the value only when the key is new.
+		auto const [x, inserted] = insert(std::forward<UK>(key), std::forward<UV>(value));
+
+		if (!inserted)
+			*x = std::forward<UV>(value);
+
+		return *x;
+	}
+
+	template<typename UK>
+	V &operator[](UK &&key){
+		if (auto *x = find(key))
+			return *x;
+
+		return insertNew__(std::forward<UK>(key), V{});
+	}
+
+	template<typename UK>
+	bool erase(UK const &key){
+		auto const it = tree.find(key, std::true_type{});
+
+		if (it == tree.end())
+			return false;
+
+		auto const slot = it->slot;
+
+		// the node is found, no second descent, see AVLMultiset::erase__().
+		auto *node = const_cast<Node *>(it.node_());
+
+		tree.unlinkNode__(node);
+		tree.deallocateNode_(node);
+
+		// the old value is destroyed now, not when the slot is reused.
+		slab[slot] = V{};
+		freeSlots.push_back(slot);
+
+		return true;
+	}
+
+public:
+	template<typename UK>
+	V *find(UK const &key){
+		return const_cast<V *>(std::as_const(*this).find(key));
+	}
+
+	template<typename UK>
+	const V *find(UK const &key) const{
+		// the slab is read only on a hit.
+
+		auto const it = tree.find(key, std::true_type{});
+
+		return it == tree.end() ? nullptr : &slab[it->slot];
+	}
+
+	template<typename UK>
+	bool contains(UK const &key) const{
+		return tree.find(key, std::true_type{}) != tree.end();
+	}
+
+public:
+	iterator begin(){
+		return { tree.begin(), &slab };
+	}
+
+	iterator end(){
+		return { Tree::end(), &slab };
+	}
+
+	const_iterator begin() const{
+		return { tree.begin(), &slab };
+	}
+
+	const_iterator end() const{
+		return { Tree::end(), &slab };
+	}
+
+public:
+	void relayout(){
+		// the nodes go in van Emde Boas order, see AVLTree::relayout(),
+		// the values in key order, without the free slots,
+		// so a scan reads the slab in order.
+
+		std::vector<V> packed;
+		packed.reserve(tree.size());
+
+		for(auto const &x : tree){
+			packed.push_back(std::move(slab[x.slot]));
+			x.slot = uint32_t(packed.size() - 1);
+		}
+
+		slab = std::move(packed);
+		freeSlots.clear();
+
+		tree.relayout();
+	}
+
+private:
+	template<typename UK, typename UV>
+	V &insertNew__(UK &&key, UV &&value){
+		// the key is not in the tree, a free slot is reused first.
+
+		uint32_t slot;
+
+		if (!freeSlots.empty()){
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+
+			slab[slot] = std::forward<UV>(value);
+		}else{
+			assert(slab.size() < std::numeric_limits<uint32_t>::max());
+
+			slot = uint32_t(slab.size());
+
+			slab.emplace_back(std::forward<UV>(value));
+		}
+
+		tree.insert(Slotted{ std::forward<UK>(key), slot });
+
+		return slab[slot];
+	}
+};
+
+
+
+template<typename T>
+class FrozenAVLTree{
+	// immutable, Eytzinger ordered copy of AVLTree,
+	// for trees that are built once and then only searched.
+
+	std::vector<T>	data;	// 1-based, data[0] is not used
+
+	template<typename, typename>
+	friend class AVLTree;
+
+public:
+	using iterator = avl_impl_::eytzinger_iterator<T>;
+
+public:
+	FrozenAVLTree() : data(1){}
+
+	size_t size() const{
+		return data.size() - 1;
+	}
+
+	AVLTree<T> thaw() const{
+		return { begin(), size() };
+	}
+
+public:
+	template<bool Exact, typename UT>
+	iterator find(UT const &key, std::bool_constant<Exact>) const{
+		auto const k = avl_impl_::eytzingerFind_<Exact>(data.data(), size(), key);
+		return { data.data(), size(), k };
+	}
+
+	iterator begin() const{
+		if (!size())
+			return end();
+
+		// leftmost
+		size_t k = 1;
+
+		while(2 * k <= size())
+			k = 2 * k;
+
+		return { data.data(), size(), k };
+	}
+
+	constexpr static iterator end(){
+		return { nullptr, 0, 0 };
+	}
+
+private:
+	template<typename It>
+	FrozenAVLTree(It first, size_t const size) : data(size + 1){
+		avl_impl_::eytzingerFill_(data.data(), size, 1, first);
+	}
+};
+
+
+
+
+template<typename T>
+class DurableAVLTree{
+	// AVLTree with a write-ahead log, survives process restarts.
+	//
+	// files:
+	//   path.snap	- snapshot, written by checkpoint()
+	//   path.wal	- mutations after the snapshot, in frames:
+	//
+	//     size : u32 | checksum : u32 | records, each op : u8 | T
+	//
+	// insert() and erase() append a record to a buffer and return.
+	// a background thread writes the buffer as one frame (group commit)
+	// and calls fsync() every syncInterval, nothing waits for the disk.
+	// syncInterval == 0 writes and syncs before insert() / erase() returns.
+	//
+	// open() loads the snapshot and replays the log as one sorted batch.
+	// a torn frame at the end of the log is dropped.
+	//
+	// mutations and checkpoint() must come from one thread, as for AVLTree.
+	// changes before open() or after close() are not logged.
+
+	static_assert(std::is_trivially_copyable_v<T>, "DurableAVLTree supports trivially copyable types only");
+
+	using Tree = AVLTree<T>;
+
+	enum Op : char{
+		OpInsert	= '+',
+		OpErase		= '-'
+	};
+
+	constexpr static size_t	FRAME_HEADER		= 2 * sizeof(uint32_t);
+	constexpr static size_t	RECORD_SIZE		= 1 + sizeof(T);
+	constexpr static size_t	GROUP_COMMIT_SIZE	= 1 << 20;	// bytes, wakes the flusher early
+	constexpr static size_t	REPLAY_MERGE		= 16;		// tree size / log records, see applyLog_()
+
+	Tree				tree;
+
+	std::string			path;
+	int				fd	= -1;
+	std::chrono::milliseconds	syncInterval;
+
+	std::mutex			mutex;		// buffer, stop
+	std::condition_variable		cv;
+	std::vector<char>		buffer;
+	bool				stop	= false;
+
+	std::mutex			ioMutex;	// fd, spare, failed
+	std::vector<char>		spare;
+	bool				failed	= false;
+
+	std::thread			flusher;
+
+public:
+	using iterator = typename Tree::iterator;
+
+public:
+	explicit DurableAVLTree(std::chrono::milliseconds const syncInterval = std::chrono::milliseconds{ 5 }) :
+					syncInterval(syncInterval){}
+
+	~DurableAVLTree(){
+		close();
+	}
+
+	bool open(std::string const &path){
+		// on error, the tree is empty and nothing is logged.
+
+		close();
+
+		this->path = path;
+
+		tree.clear();
+
+		// nothing from before open() goes in this log.
+		buffer.clear();
+		spare.clear();
+
+		if (std::ifstream is{ snapPath_(), std::ios::binary }; is && !tree.load(is))
+			return false;
+
+		size_t valid;
+
+		if (!replay_(valid))
+			return tree.clear(), false;
+
+		fd = ::open(walPath_().c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+
+		if (fd < 0)
+			return tree.clear(), false;
+
+		// cut the torn frame, if any.
+		if (::ftruncate(fd, off_t(valid)) != 0){
+			closeFd_();
+			return tree.clear(), false;
+		}
+
+		failed	= false;
+		stop	= false;
+
+		if (syncInterval.count())
+			flusher = std::thread{ &DurableAVLTree::flushLoop_, this };
+
+		return true;
+	}
+
+	void close(){
+		if (flusher.joinable()){
+			{
+				std::lock_guard lock{ mutex };
+				stop = true;
+			}
+
+			cv.notify_one();
+			flusher.join();
+		}
+
+		if (fd < 0)
+			return;
+
+		flush_();
+		closeFd_();
+	}
+
+	bool sync(){
+		// write and fsync everything so far, returns false if any write failed.
+		return flush_();
+	}
+
+	bool checkpoint(){
+		// snapshot and empty log.
+		// a crash in between replays the old log over the new snapshot,
+		// this is safe, because the last op of each key wins.
+
+		if (!flush_())
+			return false;
+
+		std::lock_guard io{ ioMutex };
+
+		std::ostringstream os;
+		tree.save(os);
+
+		auto const snap = snapPath_();
+		auto const tmp  = snap + ".tmp";
+
+		int const sfd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+		if (sfd < 0)
+			return false;
+
+		auto const s = os.str();
+
+		bool const ok = writeAll__(sfd, s.data(), s.size()) && ::fsync(sfd) == 0;
+
+		::close(sfd);
+
+		if (!ok || std::rename(tmp.c_str(), snap.c_str()) != 0)
+			return false;
+
+		syncDir_();
+
+		return ::ftruncate(fd, 0) == 0 && ::fsync(fd) == 0;
+	}
+
+	bool good(){
+		std::lock_guard io{ ioMutex };
+		return !failed;
+	}
+
+public:
+	template<typename UT>
+	iterator insert(UT &&data){
+		auto it = tree.insert(std::forward<UT>(data));
+
+		if (it != tree.end())
+			append_(OpInsert, *it);
+
+		return it;
+	}
+
+	bool erase(T const &key){
+		if (!tree.erase(key))
+			return false;
+
+		append_(OpErase, key);
+
+		return true;
+	}
+
+	const Tree &get() const{
+		return tree;
+	}
+
+	size_t size() const{
+		return tree.size();
+	}
+
+	template<bool Exact, typename UT>
+	iterator find(UT const &key, std::bool_constant<Exact> tag) const{
+		return tree.find(key, tag);
+	}
+
+	iterator begin() const{
+		return tree.begin();
+	}
+
+	constexpr static iterator end(){
+		return Tree::end();
+	}
+
+private:
+	std::string snapPath_() const{
+		return path + ".snap";
+	}
+
+	std::string walPath_() const{
+		return path + ".wal";
+	}
+
+	void append_(Op const op, T const &key){
+		// not open, the change is not logged.
+		if (fd < 0)
+			return;
+
+		{
+			std::lock_guard lock{ mutex };
+
+			buffer.push_back(op);
+
+			auto const *p = reinterpret_cast<const char *>(&key);
+			buffer.insert(std::end(buffer), p, p + sizeof(T));
+
+			if (syncInterval.count() && buffer.size() >= GROUP_COMMIT_SIZE)
+				cv.notify_one();
+		}
+
+		if (!syncInterval.count())
+			flush_();
+	}
+
+	void flushLoop_(){
+		std::unique_lock lock{ mutex };
+
+		while(!stop){
+			cv.wait_for(lock, syncInterval, [this](){
+				return stop || buffer.size() >= GROUP_COMMIT_SIZE;
+			});
+
+			lock.unlock();
+			flush_();
+			lock.lock();
+		}
+	}
+
+	bool flush_(){
+		// the buffer is swapped out, so appends do not wait for the disk.
+
+		std::lock_guard io{ ioMutex };
+
+		{
+			std::lock_guard lock{ mutex };
+			spare.swap(buffer);
+		}
+
+		if (spare.empty())
+			return !failed;
+
+		uint32_t const header[2] = { uint32_t(spare.size()), checksum__(spare.data(), spare.size()) };
+
+		bool const ok = fd >= 0
+			&& writeAll__(fd, reinterpret_cast<const char *>(header), FRAME_HEADER)
+			&& writeAll__(fd, spare.data(), spare.size())
+			&& ::fsync(fd) == 0;
+
+		spare.clear();
+
+		failed = failed || !ok;
+
+		return !failed;
+	}
+
+	void closeFd_(){
+		::close(fd);
+		fd = -1;
+	}
+
+	void syncDir_() const{
+		auto const slash = path.rfind('/');
+		auto const dir   = slash == std::string::npos ? std::string{ "." } : path.substr(0, slash + 1);
+
+		int const dfd = ::open(dir.c_str(), O_RDONLY);
+
+		if (dfd < 0)
+			return;
+
+		::fsync(dfd);
+		::close(dfd);
+	}
+
+	bool replay_(size_t &valid){
+		valid = 0;
+
+		std::ifstream is{ walPath_(), std::ios::binary };
+
+		if (!is)
+			return true;
+
+		std::vector<char> const log{ std::istreambuf_iterator<char>{ is }, std::istreambuf_iterator<char>{} };
+
+		std::vector<std::pair<T, Op> > batch;
+
+		while(log.size() - valid >= FRAME_HEADER){
+			uint32_t header[2];
+			std::copy_n(log.data() + valid, FRAME_HEADER, reinterpret_cast<char *>(header));
+
+			const char *records = log.data() + valid + FRAME_HEADER;
+			size_t const size   = header[0];
+
+			if (size > log.size() - valid - FRAME_HEADER || size % RECORD_SIZE || checksum__(records, size) != header[1])
+				break;
+
+			for(size_t i = 0; i < size; i += RECORD_SIZE){
+				auto const op = Op(records[i]);
+
+				if (op != OpInsert && op != OpErase)
+					return false;
+
+				T key;
+				std::copy_n(records + i + 1, sizeof(T), reinterpret_cast<char *>(&key));
+
+				batch.emplace_back(key, op);
+			}
+
+			valid += FRAME_HEADER + size;
+		}
+
+		applyLog_(batch);
+
+		return true;
+	}
+
+	void applyLog_(std::vector<std::pair<T, Op> > &batch){
+		// the whole log tail at once, sorted, the last op of each key is kept.
+		// a short tail is applied key by key, O(batch log n),
+		// a long one is merged with the tree, which is rebuilt once, O(n + batch).
+
+		if (batch.empty())
+			return;
+
+		std::stable_sort(std::begin(batch), std::end(batch), [](auto const &a, auto const &b){
+			return a.first < b.first;
+		});
+
+		auto const last = [&batch](size_t const i){
+			return i + 1 == batch.size() || batch[i].first < batch[i + 1].first;
+		};
+
+		if (batch.size() * REPLAY_MERGE < tree.size()){
+			for(size_t i = 0; i < batch.size(); ++i){
+				auto const &[key, op] = batch[i];
+
+				if (!last(i))
+					continue;
+
+				if (op == OpInsert)
+					tree.insert(key);
+				else
+					tree.erase(key);
+			}
+
+			batch.clear();
+
+			return;
+		}
+
+		std::vector<T> values;
+		values.reserve(tree.size() + batch.size());
+
+		auto it = tree.begin();
+
+		for(size_t i = 0; i < batch.size(); ++i){
+			auto const &[key, op] = batch[i];
+
+			if (!last(i))
+				continue;
+
+			for(; it != tree.end() && *it < key; ++it)
+				values.push_back(*it);
+
+			if (it != tree.end() && !(key < *it))
+				++it;
+
+			if (op == OpInsert)
+				values.push_back(key);
+		}
+
+		for(; it != tree.end(); ++it)
+			values.push_back(*it);
+
+		tree.clear();
+		tree.assignSorted_(std::begin(values), values.size());
+
+		batch.clear();
+	}
+
+	static bool writeAll__(int const fd, const char *data, size_t size){
+		while(size){
+			auto const n = ::write(fd, data, size);
+
+			if (n < 0 && errno == EINTR)
+				continue;
+
+			if (n <= 0)
+				return false;
+
+			data += n;
+			size -= size_t(n);
+		}
+
+		return true;
+	}
+
+	static uint32_t checksum__(const char *data, size_t const size){
+		// FNV-1a
+		uint32_t h = 2166136261u;
+
+		for(size_t i = 0; i < size; ++i)
+			h = (h ^ uint8_t(data[i])) * 16777619u;
+
+		return h;
+	}
+};
+
+
+
+template<typename T, size_t Capacity = 32>
+class AVLBlockTree{
+	// AVL tree of sorted key blocks, for small trivially copyable keys.
+	// blocks split and merge like B-tree leaves,
+	// the blocks are balanced by the same code as AVLTree.
+
+	using Node = avl_impl_::BlockNode<T, Capacity>;
+
+	Node *root = nullptr;
+
+public:
+	using iterator = avl_impl_::block_iterator<T, Capacity>;
+
+public:
+	constexpr AVLBlockTree() = default;
+
+	AVLBlockTree(AVLBlockTree const &) = delete;
+	AVLBlockTree &operator =(AVLBlockTree const &) = delete;
+
+	AVLBlockTree(AVLBlockTree &&other){
+		std::swap(root, other.root);
+	}
+
+	AVLBlockTree &operator =(AVLBlockTree &&other){
+		std::swap(root, other.root);
+		return *this;
+	}
+
+	~AVLBlockTree(){
+		deallocateTree__(root);
+	}
+
+	void check() const{
+		return avl_impl_::check(root);
+	}
+
+public:
+	void clear(){
+		deallocateTree__(root);
+		root = nullptr;
+	}
+
+	template<typename UT>
+	iterator insert(UT const &key){
+		if (!root){
+			auto *node = new Node;
+
+			node->data[0] = key;
+			node->size = 1;
+
+			root = node;
+
+			return { node, 0 };
+		}
+
+		auto *node = floor__(key);
+
+		if (!node){
+			// smaller than all keys
+			node = avl_impl_::minValueNode(root);
+		}
+
+		size_t i = avl_impl_::blockLowerBound_(node, key);
+
+		if (i < node->size && !(key < node->data[i])){
+			// found, not insert, no balance.
+			return end();
+		}
+
+		if (node->size == Capacity){
+			// split, the upper half goes in a new block right after this one.
+
+			constexpr size_t half = Capacity / 2;
+
+			auto *next = new Node;
+
+			std::copy(node->data + half, node->data + Capacity, next->data);
+			std::fill(node->data + half, node->data + Capacity, Node::EMPTY);
+
+			next->size = Capacity - half;
+			node->size = half;
+
+			linkAfter__(node, next);
+
+			if (i > half){
+				i -= half;
+				node = next;
+			}
+		}
+
+		std::copy_backward(node->data + i, node->data + node->size, node->data + node->size + 1);
+
+		node->data[i] = key;
+		++node->size;
+
+		return { node, i };
+	}
+
+	template<typename UT>
+	bool erase(UT const &key){
+		auto *node = floor__(key);
+
+		if (!node)
+			return false;
+
+		size_t const i = avl_impl_::blockLowerBound_(node, key);
+
+		if (i == node->size || key < node->data[i])
+			return false;
+
+		std::copy(node->data + i + 1, node->data + node->size, node->data + i);
+
+		--node->size;
+		node->data[node->size] = Node::EMPTY;
+
+		if (node->size < Capacity / 4)
+			merge__(node);
+
+		return true;
+	}
+
+public:
+	template<bool Exact, typename UT>
+	iterator find(UT const &key, std::bool_constant<Exact>) const{
+		const auto *node = floor__(key);
+
+		if (!node){
+			// smaller than all keys
+			if constexpr(Exact)
+				return end();
+			else
+				return begin();
+		}
+
+		size_t const i = avl_impl_::blockLowerBound_(node, key);
+
+		if (i < node->size){
+			if constexpr(Exact)
+				if (key < node->data[i])
+					return end();
+
+			return { node, i };
+		}
+
+		// greater than all keys in the block
+		if constexpr(Exact)
+			return end();
+		else
+			return { avl_impl_::nextNode_(node), 0 };
+	}
+
+	iterator begin() const{
+		return { avl_impl_::minValueNode(root), 0 };
+	}
+
+	constexpr static iterator end(){
+		return { nullptr, 0 };
+	}
+
+private:
+	template<typename UT>
+	Node *floor__(UT const &key) const{
+		// the block with the greatest first key, not greater than the key.
+		// only data[0] is used, so one cache line per level.
+
+		Node *node  = root;
+		Node *floor = nullptr;
+
+		while(node){
+			if (key < node->data[0]){
+				node = node->l;
+				continue;
+			}
+
+			if (key > node->data[0]){
+				floor = node;
+				node = node->r;
+				continue;
+			}
+
+			return node;
+		}
+
+		return floor;
+	}
+
+	void linkAfter__(Node *node, Node *next){
+		if (!node->r)
+			avl_impl_::link_(root, node, next, false);
+		else
+			avl_impl_::link_(root, avl_impl_::minValueNode(node->r), next, true);
+	}
+
+	void merge__(Node *node){
+		// merge with a neighbour, if both fit in 3/4 of a block.
+
+		if (node->size == 0){
+			avl_impl_::unlink_(root, node);
+			delete node;
+			return;
+		}
+
+		auto _ = [this](Node *a, Node *b){
+			// b goes into a
+
+			if (a->size + b->size > Capacity * 3 / 4)
+				return false;
+
+			std::copy(b->data, b->data + b->size, a->data + a->size);
+			a->size += b->size;
+
+			avl_impl_::unlink_(root, b);
+			delete b;
+
+			return true;
+		};
+
+		if (auto *next = avl_impl_::nextNode_(node); next && _(node, next))
+			return;
+
+		if (auto *prev = avl_impl_::prevNode_(node); prev)
+			_(prev, node);
+	}
+
+	static void deallocateTree__(Node *node){
+		if (!node)
+			return;
+
+		deallocateTree__(node->l);
+		deallocateTree__(node->r);
+		delete node;
+	}
+};
+
+
+
+
+template<typename T, size_t N>
+class StaticAVLTree{
+	// same as FrozenAVLTree, but in std::array,
+	// so a constexpr instance is built at compile time and lives in .rodata.
+
+	std::array<T, N + 1>	data{};	// 1-based, data[0] is not used
+	size_t			size_	= 0;
+
+public:
+	using iterator = avl_impl_::eytzinger_iterator<T>;
+
+public:
+	constexpr StaticAVLTree() = default;
+
+	template<typename It>
+	constexpr StaticAVLTree(It first, size_t const size) : size_(size){
+		assert(size <= N);
+		avl_impl_::eytzingerFill_(data.data(), size, 1, first);
+	}
+
+	constexpr size_t size() const{
+		return size_;
+	}
+
+public:
+	template<bool Exact, typename UT>
+	constexpr iterator find(UT const &key, std::bool_constant<Exact>) const{
+		auto const k = avl_impl_::eytzingerFind_<Exact>(data.data(), size(), key);
+		return { data.data(), size(), k };
+	}
+
+	constexpr iterator begin() const{
+		if (!size())
+			return end();
+
+		// leftmost
+		size_t k = 1;
+
+		while(2 * k <= size())
+			k = 2 * k;
+
+		return { data.data(), size(), k };
+	}
+
+	constexpr static iterator end(){
+		return { nullptr, 0, 0 };
+	}
+};
+
+#if __cpp_constexpr_dynamic_alloc >= 201907L
+
+template<typename T, size_t N>
+constexpr StaticAVLTree<T, N> makeStaticAVLTree(const T (&keys)[N]){
+	// the tree exists only during the constant evaluation,
+	// the result keeps just the keys. duplicates are dropped.
+
+	AVLTree<T> tree;
+
+	for(auto const &key : keys)
+		tree.insert(key);
+
+	return { std::begin(tree), size_t(std::distance(std::begin(tree), std::end(tree))) };
+}
+
+#endif
+
+
+#include <ctime>
+#include <cmath>
+#include <random>
+
+#if __cpp_constexpr_dynamic_alloc >= 201907L
+
+constexpr std::string_view KEYWORDS[] = {
+	"while", "if", "else", "for", "do", "return", "break", "continue", "switch", "case", "if"
+};
+
+constexpr auto keywords = makeStaticAVLTree(KEYWORDS);
+
+static_assert(keywords.size() == 10);
+static_assert(*keywords.begin() == "break");
+static_assert( keywords.find(std::string_view{ "return" }, std::true_type{})  != keywords.end());
+static_assert( keywords.find(std::string_view{ "goto"   }, std::true_type{})  == keywords.end());
+static_assert(*keywords.find(std::string_view{ "goto"   }, std::false_type{}) == "if");
+
+#endif
+
+
+
+// ./myavl bench [name] - timings, not tests.
+
+template<typename F>
+double benchTime(F &&f){
+	auto const start = std::chrono::steady_clock::now();
+
+	f();
+
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<typename S>
+double benchLookups(std::vector<std::string> const &keys, std::vector<std::string> const &probes){
+	AVLTree<S> tree;
+
+	for(auto const &key : keys)
+		tree.insert(S(key));
+
+	std::vector<S> const probesS(std::begin(probes), std::end(probes));
+
+	size_t found = 0;
+
+	auto const t = benchTime([&](){
+		for(auto const &key : probesS)
+			found += tree.find(key, std::true_type{}) != tree.end();
+	});
+
+	assert(found == probesS.size());
+
+	return t * 1e9 / double(probesS.size());
+}
+
+void benchStrings(){
+	constexpr size_t N = 1'000'000;
+
+	std::mt19937_64 rng(1);
+
+	auto word = [&rng](){
+		std::string s(4 + rng() % 13, ' ');
+
+		for(auto &c : s)
+			c = char('a' + rng() % 26);
+
+		return s;
+	};
+
+	auto url = [&rng](){
+		return "https://www.example.com/catalog/item/" + std::to_string(rng() % 100'000'000) + "?ref=" + std::to_string(rng() % 1000);
+	};
+
+	auto run = [](const char *name, auto &&gen){
+		std::vector<std::string> keys;
+
+		for(size_t i = 0; i < N; ++i)
+			keys.push_back(gen());
+
+		auto probes = keys;
+		std::shuffle(std::begin(probes), std::end(probes), std::mt19937_64{ 2 });
+
+		printf("%-8s find, ns: prefix %6.1f | plain %6.1f\n", name,
+				benchLookups<avl_impl_::PrefixString>(keys, probes),
+				benchLookups<std::string>(keys, probes)
+		);
+	};
+
+	run("words",	word);
+	run("urls",	url);
+}
+
+struct PlainInt{
+	// same as int, but not arithmetic, so the tree takes the branchy descent.
+	int x;
+
+	friend bool operator <(PlainInt const a, PlainInt const b){
+		return a.x < b.x;
+	}
+
+	friend bool operator >(PlainInt const a, PlainInt const b){
+		return a.x > b.x;
+	}
+};
+
+template<typename I>
+double benchIntLookups(std::vector<int> const &keys, std::vector<int> const &probes){
+	AVLTree<I> tree;
+
+	for(auto const &key : keys)
+		tree.insert(I{ key });
+
+	size_t found = 0;
+
+	auto const t = benchTime([&](){
+		for(auto const &key : probes)
+			found += tree.find(I{ key }, std::true_type{}) != tree.end();
+	});
+
+	assert(found == probes.size());
+
+	return t * 1e9 / double(probes.size());
+}
+
+void benchInts(){
+	for(size_t const n : { 1'000'000, 10'000'000, 100'000'000 }){
+		std::mt19937 rng(1);
+
+		std::vector<int> keys(n);
+
+		for(auto &key : keys)
+			key = int(rng());
+
+		std::vector<int> probes(std::min<size_t>(n, 10'000'000));
+
+		for(auto &key : probes)
+			key = keys[rng() % n];
+
+		printf("%9zu find, ns: branchless %6.1f | branchy %6.1f\n", n,
+				benchIntLookups<int     >(keys, probes),
+				benchIntLookups<PlainInt>(keys, probes)
+		);
+	}
+}
+
+void benchBuild(){
+	constexpr size_t N = 10'000'000;
+
+	std::mt19937 rng(1);
+
+	std::vector<int> keys(N);
+
+	for(auto &key : keys)
+		key = int(rng());
+
+	auto const inserts = benchTime([&](){
+		AVLTree<int> tree;
+
+		for(auto const &key : keys)
+			tree.insert(key);
+	});
+
+	printf("%zu unsorted keys, build, s: inserts %6.2f\n", N, inserts);
+
+	for(unsigned threads = 1; threads <= std::max(std::thread::hardware_concurrency(), 1u); threads *= 2){
+		auto const t = benchTime([&](){
+			AVLTree<int> tree;
+			tree.build_parallel(std::begin(keys), std::end(keys), threads);
+		});
+
+		printf("%zu unsorted keys, build, s: build_parallel, %2u threads %6.2f\n", N, threads, t);
+	}
+}
+
+void benchScan(){
+	constexpr size_t N = 100'000'000;
+
+	std::vector<int> keys(N);
+
+	for(size_t i = 0; i < N; ++i)
+		keys[i] = int(i);
+
+	AVLTree<int> tree;
+	tree.build_parallel(std::begin(keys), std::end(keys));
+
+	keys = {};
+
+	int64_t sum = 0;
+
+	auto const iterator = benchTime([&](){
+		for(auto const &x : tree)
+			sum += x;
+	});
+
+	printf("%zu nodes, sum, s: iterator %6.2f, sum %lld\n", N, iterator, (long long) sum);
+
+	for(unsigned threads = 1; threads <= std::max(std::thread::hardware_concurrency(), 1u); threads *= 2){
+		int64_t psum = 0;
+
+		auto const t = benchTime([&](){
+			psum = tree.parallel_reduce(int64_t{ 0 }, [](int x){
+				return int64_t{ x };
+			}, std::plus<int64_t>{}, threads);
+		});
+
+		printf("%zu nodes, sum, s: parallel_reduce, %2u threads %6.2f, sum %lld\n", N, threads, t, (long long) psum);
+	}
+}
+
+void benchClone(){
+	constexpr size_t N = 10'000'000;
+
+	std::mt19937 rng(1);
+
+	std::vector<int> keys(N);
+
+	for(auto &key : keys)
+		key = int(rng());
+
+	AVLTree<int> tree;
+
+	for(auto const &key : keys)
+		tree.insert(key);
+
+	auto const inserts = benchTime([&](){
+		AVLTree<int> copy;
+
+		for(auto const &key : tree)
+			copy.insert(key);
+	});
+
+	AVLTree<int> copy;
+
+	auto const clone = benchTime([&](){
+		copy = tree.clone();
+	});
+
+	printf("%zu nodes, copy, s: inserts %6.2f | clone %6.2f\n", N, inserts, clone);
+
+	std::shuffle(std::begin(keys), std::end(keys), rng);
+
+	auto lookups = [&keys](AVLTree<int> const &tree){
+		size_t found = 0;
+
+		auto const t = benchTime([&](){
+			for(auto const &key : keys)
+				found += tree.find(key, std::true_type{}) != tree.end();
+		});
+
+		return found == keys.size() ? t * 1e9 / double(keys.size()) : -1;
+	};
+
+	printf("%zu nodes, find, ns: original %6.1f | clone %6.1f\n", N, lookups(tree), lookups(copy));
+}
+
+void benchHash(){
+	for(size_t const n : { 1'000'000, 10'000'000, 20'000'000 }){
+		std::mt19937 rng(1);
+
+		std::vector<int> keys(n);
+
+		for(auto &key : keys)
+			key = int(rng());
+
+		// 90% hits
+		std::vector<int> probes(10'000'000);
+
+		for(auto &key : probes)
+			key = rng() % 10 ? keys[rng() % n] : int(rng());
+
+		AVLTree<int> tree;
+
+		auto const inserts = benchTime([&](){
+			for(auto const &key : keys)
+				tree.insert(key);
+		});
+
+		auto const indexing = benchTime([&](){
+			tree.set_hash_index(true);
+		});
+
+		auto lookups = [&](){
+			size_t found = 0;
+
+			auto const t = benchTime([&](){
+				for(auto const &key : probes)
+					found += tree.find(key, std::true_type{}) != tree.end();
+			});
+
+			return std::make_pair(t * 1e9 / double(probes.size()), found);
+		};
+
+		auto const [hash, foundHash] = lookups();
+
+		tree.set_hash_index(false);
+
+		auto const [descent, foundDescent] = lookups();
+
+		printf("%9zu insert, ns %6.1f, index build, s %5.2f | find, ns: hash %6.1f | descent %6.1f | found %zu %zu\n", n,
+				inserts * 1e9 / double(n),
+				indexing,
+				hash,
+				descent,
+				foundHash, foundDescent
+		);
+	}
+}
+
+void benchCache(){
+	constexpr size_t N = 10'000'000;
+	constexpr size_t P = 10'000'000;
+	constexpr double S = 0.99;
+
+	std::mt19937 rng(1);
+
+	std::vector<int> keys(N);
+
+	for(auto &key : keys)
+		key = int(rng());
+
+	AVLTree<int> tree;
+
+	for(auto const &key : keys)
+		tree.insert(key);
+
+	// Zipf over the ranks, rank r has weight 1 / r^S.
+	// the ranks are in random key order, so the hot keys are all over the tree.
+	std::vector<double> cdf(N);
+
+	double sum = 0;
+
+	for(size_t i = 0; i < N; ++i)
+		cdf[i] = sum += 1 / std::pow(double(i + 1), S);
+
+	std::uniform_real_distribution<double> u(0, sum);
+
+	std::vector<int> probes(P);
+
+	for(auto &key : probes)
+		key = keys[size_t(std::lower_bound(std::begin(cdf), std::end(cdf), u(rng)) - std::begin(cdf))];
+
+	cdf = {};
+
+	for(size_t const slots : { 0, 1 << 10, 1 << 14, 1 << 18 }){
+		tree.set_front_cache(slots);
+
+		size_t found = 0;
+
+		auto const t = benchTime([&](){
+			for(auto const &key : probes)
+				found += tree.find(key, std::true_type{}) != tree.end();
+		});
+
+		auto const stats = tree.front_cache_stats();
+
+		printf("%zu keys, zipf %.2f, find, ns: cache %7zu slots %6.1f, hit rate %5.1f%%, found %zu\n", N, S, slots,
+				t * 1e9 / double(P),
+				slots ? 100.0 * double(stats.hits) / double(stats.hits + stats.misses) : 0.0,
+				found
+		);
+	}
+}
+
+void benchBloom(){
+	// a dedup lookup, most keys are new.
+
+	constexpr size_t N = 10'000'000;
+	constexpr size_t P = 10'000'000;
+	constexpr size_t HIT = 10;	// %
+
+	std::mt19937 rng(1);
+
+	std::vector<int> keys(N);
+
+	for(auto &key : keys)
+		key = int(rng() & ~1u);	// even, so odd keys are misses
+
+	AVLTree<int> tree;
+
+	for(auto const &key : keys)
+		tree.insert(key);
+
+	std::vector<int> probes(P);
+
+	for(auto &key : probes)
+		key = rng() % 100 < HIT ? keys[rng() % N] : int(rng() | 1);
+
+	for(size_t const bitsPerKey : { 0, 8, 10, 16 }){
+		tree.set_bloom_filter(bitsPerKey);
+
+		size_t found = 0;
+
+		auto const t = benchTime([&](){
+			for(auto const &key : probes)
+				found += tree.find(key, std::true_type{}) != tree.end();
+		});
+
+		printf("%zu keys, %zu%% hits, find, ns: bloom %2zu bits per key %6.1f, %5.1f MB, found %zu\n", N, HIT, bitsPerKey,
+				t * 1e9 / double(P),
+				double(tree.bloom_filter_bytes()) / (1 << 20),
+				found
+		);
+	}
+
+	// false positive rate, on misses only.
+	for(size_t const bitsPerKey : { 8, 10, 16 }){
+		avl_impl_::BloomFilter filter(bitsPerKey, N);
+
+		for(auto const &key : keys)
+			filter.insert(avl_impl_::hashKey_<int>(key));
+
+		size_t positive = 0;
+
+		for(size_t i = 0; i < P; ++i)
+			positive += filter.mayContain(avl_impl_::hashKey_<int>(int(rng() | 1)));
+
+		printf("%zu keys, bloom %2zu bits per key, false positives %5.2f%%\n", N, bitsPerKey,
+				100.0 * double(positive) / double(P)
+		);
+	}
+}
+
+// a key with a big value in the node, the layout AVLSlabMap avoids.
+
+struct BenchRecord{
+	int	key;
+	char	payload[252];
+
+	static int key_(int const key){
+		return key;
+	}
+
+	static int key_(BenchRecord const &x){
+		return x.key;
+	}
+
+	template<typename A, typename B>
+	friend bool operator <(A const &a, B const &b){
+		return key_(a) < key_(b);
+	}
+
+	template<typename A, typename B>
+	friend bool operator >(A const &a, B const &b){
+		return key_(a) > key_(b);
+	}
+};
+
+void benchSlab(){
+	constexpr size_t N = 2'000'000;
+	constexpr size_t P = 10'000'000;
+
+	std::mt19937 rng(1);
+
+	std::vector<int> keys(N);
+
+	for(auto &key : keys)
+		key = int(rng());
+
+	std::vector<int> probes(P);
+
+	for(auto &key : probes)
+		key = keys[rng() % N];
+
+	using Payload = std::array<char, sizeof BenchRecord::payload>;
+
+	auto run = [&](const char *name, auto const &find){
+		size_t sum = 0;
+
+		auto const t = benchTime([&](){
+			for(auto const &key : probes)
+				sum += uint8_t(find(key));
+		});
+
+		printf("%zu keys, %zu byte values, find, ns: %-10s %6.1f, sum %zu\n", N, sizeof(Payload), name,
+				t * 1e9 / double(P),
+				sum
+		);
+	};
+
+	{
+		AVLTree<BenchRecord> tree;
+
+		for(auto const &key : keys)
+			tree.insert(BenchRecord{ key, { char(key) } });
+
+		run("in node", [&](int const key){
+			return tree.find(key, std::true_type{})->payload[0];
+		});
+	}
+
+	{
+		AVLSlabMap<int, Payload> map;
+
+		for(auto const &key : keys)
+			map.insert(key, Payload{ char(key) });
+
+		run("slab", [&](int const key){
+			return (*map.find(key))[0];
+		});
+
+		map.relayout();
+
+		run("slab, veb", [&](int const key){
+			return (*map.find(key))[0];
+		});
+	}
+}
+
+void benchFindMany(){
+	// the same lookups, one by one and in prefetched groups.
+
+	constexpr size_t N = 4'000'000;
+
+	std::mt19937_64 rng(1);
+
+	std::vector<uint64_t> keys(N);
+
+	for(auto &key : keys)
+		key = rng();
+
+	AVLTree<uint64_t> tree;
+
+	for(auto const &key : keys)
+		tree.insert(key);
+
+	// 90% hits, in random order
+	std::vector<uint64_t> probes(N);
+
+	for(auto &key : probes)
+		key = rng() % 10 ? keys[rng() % N] : rng();
+
+	std::vector<AVLTree<uint64_t>::iterator> loop, many;
+
+	loop.reserve(N);
+	many.reserve(N);
+
+	auto const tLoop = benchTime([&](){
+		for(auto const &key : probes)
+			loop.push_back(tree.find(key, std::true_type{}));
+	});
+
+	auto const tMany = benchTime([&](){
+		tree.find_many(std::begin(probes), std::end(probes), std::back_inserter(many), std::true_type{});
+	});
+
+	assert(loop == many);
+
+	printf("%zu keys, find, ns: find() %6.1f | find_many() %6.1f, group %zu\n", N,
+			tLoop * 1e9 / double(N),
+			tMany * 1e9 / double(N),
+			AVLTree<uint64_t>::FIND_MANY_GROUP
+	);
+}
+
+template<typename Balance>
+void benchBalance(const char *name, std::vector<int> const &keys, std::vector<int> const &churn){
+	// keys are inserted, then each churn step erases one key and inserts another,
+	// so the size stays the same.
+
+	using Clock = std::chrono::steady_clock;
+
+	AVLTree<int, Balance> tree;
+
+#ifdef AVL_STATS
+	avl_impl_::stats = {};
+#endif
+
+	auto const inserts = benchTime([&](){
+		for(auto const &key : keys)
+			tree.insert(key);
+	});
+
+#ifdef AVL_STATS
+	auto const insertStats = avl_impl_::stats;
+	avl_impl_::Stats eraseStats;
+#endif
+
+	std::vector<double> latency;
+	latency.reserve(churn.size());
+
+	for(size_t i = 0; i < churn.size(); ++i){
+	#ifdef AVL_STATS
+		avl_impl_::stats = {};
+	#endif
+
+		auto const start = Clock::now();
+
+		tree.erase(keys[i]);
+
+		latency.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+
+	#ifdef AVL_STATS
+		eraseStats.rotations	+= avl_impl_::stats.rotations;
+		eraseStats.writes	+= avl_impl_::stats.writes;
+	#endif
+
+		tree.insert(churn[i]);
+	}
+
+	auto const erases = std::accumulate(std::begin(latency), std::end(latency), 0.0) / double(latency.size());
+
+	std::sort(std::begin(latency), std::end(latency));
+
+	printf("%-5s insert, ns %6.1f | erase, ns %6.1f, p99.9 %7.1f, max %9.1f\n", name,
+			inserts * 1e9 / double(keys.size()),
+			erases,
+			latency[latency.size() * 999 / 1000],
+			latency.back()
+	);
+
+#ifdef AVL_STATS
+	auto const n = double(keys.size());
+	auto const m = double(churn.size());
+
+	printf("%-5s per insert: rotations %5.3f, writes %5.3f | per erase: rotations %5.3f, writes %5.3f\n", name,
+			double(insertStats.rotations) / n, double(insertStats.writes) / n,
+			double(eraseStats.rotations) / m, double(eraseStats.writes) / m
+	);
+#endif
+}
+
+void benchWavl(){
+	constexpr size_t N = 1'000'000;
+
+	std::mt19937 rng(1);
+
+	std::vector<int> keys(N);
+	std::vector<int> churn(N);
+
+	for(auto &key : keys)
+		key = int(rng() >> 1);
+
+	for(auto &key : churn)
+		key = -int(rng() >> 1) - 1;
+
+	benchBalance<avl_impl_::AVLBalance >("avl",  keys, churn);
+	benchBalance<avl_impl_::WAVLBalance>("wavl", keys, churn);
+}
+
+int bench(std::string_view const name){
+	if (name.empty() || name == "strings")
+		benchStrings();
+
+	if (name.empty() || name == "ints")
+		benchInts();
+
+	if (name.empty() || name == "build")
+		benchBuild();
+
+	if (name.empty() || name == "scan")
+		benchScan();
+
+	if (name.empty() || name == "clone")
+		benchClone();
+
+	if (name.empty() || name == "wavl")
+		benchWavl();
+
+	if (name.empty() || name == "hash")
+		benchHash();
+
+	if (name.empty() || name == "cache")
+		benchCache();
+
+	if (name.empty() || name == "bloom")
+		benchBloom();
+
+	if (name.empty() || name == "slab")
+		benchSlab();
+
+	if (name.empty() || name == "many")
+		benchFindMany();
+
+	return 0;
+}
+
+int main(int argc, char **argv){
+	if (argc > 1 && std::string_view{ argv[1] } == "bench")
+		return bench(argc > 2 ? argv[2] : "");
+
+	auto insert = [](auto &tree, auto const &val){
+		auto it = tree.insert(val);
+		assert(*it == val);
+		tree.check();
+	};
+
+	if constexpr(true){
 		AVLTree<int> tree;
 		tree.insert( 167958);
 		tree.insert( 480816);
@@ -732,89 +6057,807 @@ int main(){
 		tree.check();
 		tree.insert( 403837);
 
-		tree.clear();
+		tree.clear();
+
+		tree.insert(10);
+		tree.insert(20);
+		tree.insert(30);
+		tree.insert(40);
+		tree.insert(50);
+		tree.insert(60);
+		tree.insert(70);
+		tree.insert(80);
+		tree.insert(90);
+		tree.erase(40);
+		tree.erase(50);
+		tree.erase(60);
+		tree.erase(70);
+
+		bool u;
+
+		insert(tree, 3);
+		insert(tree, 4);
+		insert(tree, 5);
+		insert(tree, 6);
+		insert(tree, 1);
+		insert(tree, 2);
+
+		tree.clear();
+
+		insert(tree, 10);
+		u = tree.erase(10); assert(u);
+
+		printf("--------\n"); tree.printPretty();
+
+		tree.clear();
+
+		insert(tree, 10);
+		insert(tree, 20);
+		insert(tree, 30);
+		insert(tree, 40);
+		insert(tree, 50);
+		insert(tree, 60);
+		insert(tree, 70);
+		insert(tree, 80);
+		insert(tree, 90);
+
+		tree.insert(25);
+
+		printf("--------\n"); tree.printPretty();
+
+		u = tree.erase(25); assert(u);
+		u = tree.erase(25); assert(!u);
+
+		printf("--------\n"); tree.printPretty();
+
+		u = tree.erase(40); assert(u);
+		u = tree.erase(40); assert(!u);
+
+		printf("--------\n"); tree.printPretty();
+
+		u = tree.erase(80); assert(u);
+		u = tree.erase(80); assert(!u);
+
+		printf("--------\n"); tree.printPretty();
+
+		insert(tree, 95);
+		insert(tree, 98);
+
+		printf("--------\n"); tree.printPretty();
+
+		for(auto const &x : tree)
+			std::cout << x << '\n';
+
+		printf("--------\n");
+
+		assert( tree.find( 5, std::true_type{}) == std::end(tree));
+		assert(*tree.find( 5, std::false_type{}) == 10);
+		assert(*tree.find( 9, std::false_type{}) == 10);
+		assert(*tree.find(11, std::false_type{}) == 20);
+
+		assert(*tree.find(49, std::false_type{}) == 50);
+		assert(*tree.find(51, std::false_type{}) == 60);
+
+		assert(*tree.find(97, std::false_type{}) == 98);
+		assert( tree.find(99, std::false_type{}) == std::end(tree));
+
+		printf("--------\n");
+
+		tree.clear();
+
+		for(int i = -5000; i < 5000; ++i)
+			tree.insert(i * 3);
+
+		std::stringstream raw, packed;
+
+		tree.save(raw, avl_impl_::SnapshotFormat::Raw);
+		tree.save(packed);
+
+		printf("snapshot raw %zu, packed %zu bytes\n", raw.str().size(), packed.str().size());
+
+		AVLTree<int> copy;
+
+		u = copy.load(raw);	assert(u); copy.check();
+		assert(std::equal(std::begin(tree), std::end(tree), std::begin(copy), std::end(copy)));
+
+		u = copy.load(packed);	assert(u); copy.check();
+		assert(std::equal(std::begin(tree), std::end(tree), std::begin(copy), std::end(copy)));
+
+		for(auto const format : { avl_impl_::SnapshotFormat::Raw, avl_impl_::SnapshotFormat::DeltaPacked }){
+			// a corrupt size, far more keys than bytes.
+			std::string header = raw.str().substr(0, sizeof avl_impl_::SNAPSHOT_MAGIC + 2);
+
+			header[sizeof avl_impl_::SNAPSHOT_MAGIC] = char(format);
+			header += "\xff\xff\xff\xff\xff\xff\xff\x7f";
+
+			std::stringstream bad{ header + "\x01\x02\x03" };
+
+			u = !copy.load(bad);	assert(u);
+			assert(std::equal(std::begin(tree), std::end(tree), std::begin(copy), std::end(copy)));
+		}
+
+		printf("--------\n");
+
+		auto const frozen = tree.freeze();
+
+		assert(std::equal(std::begin(tree), std::end(tree), std::begin(frozen), std::end(frozen)));
+
+		for(int i = -15010; i < 15010; ++i){
+			assert((tree.find(i, std::true_type{}) == std::end(tree)) == (frozen.find(i, std::true_type{}) == std::end(frozen)));
+
+			auto const it = tree.find(i, std::false_type{});
+			auto const jt = frozen.find(i, std::false_type{});
+
+			assert((it == std::end(tree)) == (jt == std::end(frozen)));
+			assert(it == std::end(tree) || *it == *jt);
+		}
+
+		auto const thawed = frozen.thaw();
+		thawed.check();
+
+		assert(std::equal(std::begin(tree), std::end(tree), std::begin(thawed), std::end(thawed)));
+
+		printf("--------\n");
+
+		tree.relayout();
+		tree.check();
+
+		assert(std::equal(std::begin(tree), std::end(tree), std::begin(frozen), std::end(frozen)));
+
+		for(int i = -5000; i < 5000; i += 2){
+			u = tree.erase(i * 3);	assert(u);
+			u = tree.insert(i * 3 + 1) != std::end(tree);	assert(u);
+		}
+
+		tree.check();
+		tree.relayout();
+		tree.check();
+
+		printf("--------\n");
+
+		{
+			AVLTree<int> pq;
+
+			for(int i = 0; i < 1000; ++i)
+				pq.insert((i * 7919) % 1000);
+
+			assert(pq.size() == 1000 && *pq.min() == 0 && *pq.max() == 999);
+
+			for(int i = 0; i < 500; ++i){
+				assert(*pq.min() == i      ); u = pq.pop_min(); assert(u);
+				assert(*pq.max() == 999 - i); u = pq.pop_max(); assert(u);
+
+				pq.check();
+			}
+
+			assert(pq.empty() && pq.begin() == pq.end());
+			u = pq.pop_min(); assert(!u);
+
+			for(int i = 0; i < 1000; ++i)
+				pq.insert(i);
+
+			u = pq.erase_below(100)		== 100;	assert(u);
+			u = pq.erase_above(899)		== 100;	assert(u);
+			u = pq.erase_range(200, 300)	== 100;	assert(u);
+			u = pq.erase_range(300, 200)	==   0;	assert(u);
+
+			pq.check();
+
+			assert(pq.size() == 700 && *pq.min() == 100 && *pq.max() == 899);
+			assert(*pq.find(200, std::false_type{}) == 300);
+
+			u = pq.erase_if([](int const &x){
+				return x % 3 == 0;
+			}) == 233; assert(u);
+
+			pq.check();
+
+			assert(pq.size() == 467 && *pq.min() == 100 && *pq.max() == 899);
+			assert(pq.find(102, std::true_type{}) == pq.end());
+		}
+
+		printf("--------\n");
+
+		{
+			AVLTree<int> lazy;
+
+			lazy.set_lazy_erase(0.5);
+
+			for(int i = 0; i < 100; ++i)
+				lazy.insert(i);
+
+			for(int i = 0; i < 100; i += 2)
+				lazy.erase(i);
+
+			// 50 dead of 100, no rebuild yet.
+			assert(lazy.size() == 50 && lazy.dead() == 50);
+			assert(lazy.find(10, std::true_type {}) == lazy.end());
+			assert(*lazy.find(10, std::false_type{}) == 11);
+			assert(*lazy.min() == 1 && *lazy.max() == 99);
+			assert(std::distance(lazy.begin(), lazy.end()) == 50);
+
+			lazy.insert(10);
+			assert(lazy.size() == 51 && lazy.dead() == 49);
+
+			lazy.erase(1);
+			lazy.erase(3);
+			assert(lazy.size() == 49 && lazy.dead() == 0);
+
+			lazy.check();
+
+			lazy.erase(99);
+			lazy.set_lazy_erase(0);
+			assert(lazy.size() == 48 && lazy.dead() == 0 && *lazy.max() == 97);
+		}
+
+		{
+			// a lazy erased key comes back with the new value, not the old one.
+			AVLTree<BenchRecord> records, other;
+
+			records.set_lazy_erase(0.5);
+
+			for(int i = 0; i < 10; ++i)
+				records.insert(BenchRecord{ i, { 'a' } });
 
-		tree.insert(10);
-		tree.insert(20);
-		tree.insert(30);
-		tree.insert(40);
-		tree.insert(50);
-		tree.insert(60);
-		tree.insert(70);
-		tree.insert(80);
-		tree.insert(90);
-		tree.erase(40);
-		tree.erase(50);
-		tree.erase(60);
-		tree.erase(70);
+			records.erase(3);
+			records.insert(BenchRecord{ 3, { 'b' } });
+			assert(records.find(3, std::true_type{})->payload[0] == 'b');
 
-		bool u;
+			auto handle = records.extract(4);
+			handle.value().payload[0] = 'c';
+			records.insert(BenchRecord{ 4, { 'x' } });
+			records.erase(4);
 
-		insert(tree, 3);
-		insert(tree, 4);
-		insert(tree, 5);
-		insert(tree, 6);
-		insert(tree, 1);
-		insert(tree, 2);
+			records.insert(std::move(handle));
+			assert(records.find(4, std::true_type{})->payload[0] == 'c');
 
-		tree.clear();
+			records.erase(5);
+			other.insert(BenchRecord{ 5, { 'd' } });
+			records.merge(other);
+			assert(records.find(5, std::true_type{})->payload[0] == 'd' && other.empty());
 
-		insert(tree, 10);
-		u = tree.erase(10); assert(u);
+			assert(records.size() == 10 && records.dead() == 0);
+			records.check();
+		}
 
-		printf("--------\n"); tree.printPretty();
+		printf("--------\n");
 
-		tree.clear();
+		{
+			std::string const path = "myavl_durable";
 
-		insert(tree, 10);
-		insert(tree, 20);
-		insert(tree, 30);
-		insert(tree, 40);
-		insert(tree, 50);
-		insert(tree, 60);
-		insert(tree, 70);
-		insert(tree, 80);
-		insert(tree, 90);
+			DurableAVLTree<int> durable;
 
-		tree.insert(25);
+			u = durable.open(path); assert(u);
 
-		printf("--------\n"); tree.printPretty();
+			for(int i = 0; i < 1000; ++i)
+				durable.insert(i);
 
-		u = tree.erase(25); assert(u);
-		u = tree.erase(25); assert(!u);
+			u = durable.checkpoint(); assert(u);
 
-		printf("--------\n"); tree.printPretty();
+			for(int i = 0; i < 1000; i += 2)
+				durable.erase(i);
 
-		u = tree.erase(40); assert(u);
-		u = tree.erase(40); assert(!u);
+			for(int i = 1000; i < 1500; ++i)
+				durable.insert(i);
 
-		printf("--------\n"); tree.printPretty();
+			durable.erase(1001);
+			durable.insert(0);
 
-		u = tree.erase(80); assert(u);
-		u = tree.erase(80); assert(!u);
+			u = durable.sync(); assert(u);
 
-		printf("--------\n"); tree.printPretty();
+			// torn frame at the end, as after a crash in the middle of write().
+			{
+				std::ofstream wal{ path + ".wal", std::ios::binary | std::ios::app };
+				wal.write("\x10\0\0\0garbage", 11);
+			}
 
-		insert(tree, 95);
-		insert(tree, 98);
+			DurableAVLTree<int> recovered{ std::chrono::milliseconds{ 0 } };
 
-		printf("--------\n"); tree.printPretty();
+			u = recovered.open(path); assert(u);
 
-		for(auto const &x : tree)
-			std::cout << x << '\n';
+			recovered.get().check();
+
+			assert(recovered.size() == durable.size() && recovered.size() == 1000);
+			assert(std::equal(recovered.begin(), recovered.end(), durable.begin(), durable.end()));
+
+			recovered.close();
+			durable.close();
+
+			std::remove((path + ".snap").c_str());
+			std::remove((path + ".wal" ).c_str());
+
+			// changes while not open are not logged, open() drops them.
+			DurableAVLTree<int> early;
+
+			early.insert(777);
+
+			u = early.open(path); assert(u);
+			assert(early.size() == 0);
+
+			early.insert(1);
+			early.close();
+
+			early.insert(2);
+
+			u = early.open(path); assert(u);
+
+			assert(early.size() == 1 && *early.begin() == 1);
+
+			early.close();
+
+			std::remove((path + ".snap").c_str());
+			std::remove((path + ".wal" ).c_str());
+		}
 
 		printf("--------\n");
 
-		assert( tree.find( 5, std::true_type{}) == std::end(tree));
-		assert(*tree.find( 5, std::false_type{}) == 10);
-		assert(*tree.find( 9, std::false_type{}) == 10);
-		assert(*tree.find(11, std::false_type{}) == 20);
+		{
+			std::vector<int> keys;
 
-		assert(*tree.find(49, std::false_type{}) == 50);
-		assert(*tree.find(51, std::false_type{}) == 60);
+			for(int i = 0; i < 100'000; ++i)
+				keys.push_back(i * 7919 % 50'000);
 
-		assert(*tree.find(97, std::false_type{}) == 98);
-		assert( tree.find(99, std::false_type{}) == std::end(tree));
+			AVLTree<int> built;
+
+			built.insert(-1);
+			built.build_parallel(std::begin(keys), std::end(keys), 4);
+
+			built.check();
+
+			assert(built.size() == 50'000 && *built.min() == 0 && *built.max() == 49'999);
+			assert(std::distance(built.begin(), built.end()) == 50'000);
+
+			built.erase(0);
+			built.insert(50'000);
+			built.check();
+
+			auto const sum = built.parallel_reduce(int64_t{ 0 }, [](int x){
+				return int64_t{ x };
+			}, std::plus<int64_t>{}, 4);
+
+			assert(sum == int64_t{ 50'000 } * 50'001 / 2);
+
+			// order sensitive
+			auto const ordered = built.parallel_reduce(std::vector<int>{}, [](int x){
+				return std::vector<int>{ x };
+			}, [](std::vector<int> a, std::vector<int> const &b){
+				a.insert(std::end(a), std::begin(b), std::end(b));
+				return a;
+			}, 4);
+
+			assert(std::equal(std::begin(ordered), std::end(ordered), built.begin(), built.end()));
+
+			std::vector<char> seen(50'001);
+
+			built.parallel_for_each([&seen](int x){
+				++seen[size_t(x)];
+			}, 4);
+
+			assert(seen[0] == 0 && std::count(std::begin(seen), std::end(seen), 1) == 50'000);
+
+			built.set_lazy_erase(0.5);
+			built.erase(1);
+
+			auto copy = built.clone();
+
+			copy.check();
+
+			assert(copy.size() == built.size() && copy.dead() == 1);
+			assert(std::equal(copy.begin(), copy.end(), built.begin(), built.end()));
+
+			copy.erase(2);
+			copy.insert(1);
+			assert(built.find(2, std::true_type{}) != built.end());
+			assert(built.find(1, std::true_type{}) == built.end());
+
+			AVLTree<int> moved = std::move(copy);
+
+			assert(copy.empty() && copy.begin() == copy.end());
+			assert(moved.size() == built.size() && *moved.min() == 1);
+
+			copy = std::move(moved);
+			copy.check();
+		}
+
+		printf("--------\n");
+
+		{
+			AVLTree<int> hot, cold;
+
+			for(int i = 0; i < 100; ++i)
+				hot.insert(i);
+
+			for(int i = 50; i < 150; ++i)
+				cold.insert(i);
+
+			const int *key = &*hot.find(10, std::true_type{});
+
+			auto handle = hot.extract(10);
+			assert(handle && handle.value() == 10 && hot.size() == 99);
+
+			auto it = cold.insert(std::move(handle));
+			assert(!handle && &*it == key);
+
+			handle = hot.extract(hot.find(60, std::true_type{}));
+			it = cold.insert(std::move(handle));
+			assert(it == cold.end() && handle && handle.value() == 60);
+
+			hot.merge(cold);
+			hot.check();
+			cold.check();
+
+			// 50..99 were in both, 60 is in handle.
+			assert(hot.size() == 150 && cold.size() == 49);
+			assert(*cold.begin() == 50 && cold.find(60, std::true_type{}) == cold.end());
+		}
+
+		printf("--------\n");
+
+		{
+			AVLTree<int, avl_impl_::WAVLBalance> weak;
+
+			for(int i = 0; i < 1000; ++i)
+				weak.insert((i * 7919) % 1000);
+
+			weak.check();
+
+			for(int i = 0; i < 1000; i += 3)
+				weak.erase(i);
+
+			weak.check();
+
+			bool u;
+
+			u = weak.erase_below(100)		==  66;	assert(u);
+			u = weak.erase_above(899)		==  66;	assert(u);
+			u = weak.erase_range(200, 300)		==  67;	assert(u);
+			weak.check();
+
+			assert(weak.size() == 666 - 66 - 66 - 67);
+			assert(*weak.min() == 100 && *weak.max() == 899);
+
+			weak.relayout();
+			weak.check();
+
+			for(int i = 0; i < 1000; ++i)
+				weak.erase(i);
+
+			assert(weak.empty());
+		}
+
+		printf("--------\n");
+
+		{
+			AVLMultiset<int> bag;
+
+			for(int i = 0; i < 100; ++i)
+				bag.insert(i % 10);
+
+			bag.check();
+
+			assert(bag.size() == 100 && bag.distinct() == 10);
+			assert(bag.count(3) == 10 && bag.count(10) == 0);
+
+			auto const [first, last] = bag.equal_range(3);
+			assert(std::distance(first, last) == 10 && *first == 3);
+			assert(std::distance(bag.begin(), bag.end()) == 100);
+
+			bool u;
+
+			u = bag.erase_one(3)		== true;	assert(u);
+			u = bag.erase(4)		== 10;		assert(u);
+			u = bag.erase(4)		==  0;		assert(u);
+			assert(bag.count(3) == 9 && bag.size() == 89);
+
+			AVLMultiset<int> other;
+			other.insert(3);
+			other.insert(42);
+
+			bag.merge(other);
+			bag.check();
+			other.check();
+
+			assert(other.empty() && bag.count(3) == 10 && bag.count(42) == 1 && bag.size() == 91);
+
+			for(int i = 0; i < 10; ++i)
+				bag.erase_one(7);
+
+			assert(bag.count(7) == 0 && bag.distinct() == 9);
+		}
+
+		printf("--------\n");
+
+		{
+			AVLTree<std::string> indexed;
+
+			for(int i = 0; i < 1000; ++i)
+				indexed.insert(std::to_string(i));
+
+			indexed.set_hash_index(true);
+			assert(indexed.hash_index());
+
+			for(int i = 0; i < 1000; i += 2)
+				indexed.erase(std::to_string(i));
+
+			indexed.insert("1000");
+			indexed.relayout();
+
+			for(int i = 0; i <= 1000; ++i){
+				bool const found = indexed.find(std::to_string(i), std::true_type{}) != indexed.end();
+				assert(found == (i % 2 || i == 1000));
+			}
+
+			assert(indexed.find(std::string_view{ "999" }, std::true_type{}) != indexed.end());
+			assert(*indexed.find(std::string_view{ "998" }, std::false_type{}) == "999");
+
+			indexed.set_hash_index(false);
+			assert(indexed.find(std::string_view{ "999" }, std::true_type{}) != indexed.end());
+		}
+
+		{
+			// keys longer and shorter than the prefix, some equal in the first 8 bytes.
+			AVLTree<avl_impl_::PrefixString> prefixed;
+
+			for(int i = 0; i < 1000; ++i)
+				prefixed.insert(std::string(size_t(i % 12), 'a') + std::to_string(i));
+
+			prefixed.check();
+			prefixed.set_hash_index(true);
+
+			assert(std::is_sorted(std::begin(prefixed), std::end(prefixed)));
+
+			for(int i = 0; i < 1000; ++i){
+				auto const key = std::string(size_t(i % 12), 'a') + std::to_string(i);
+
+				assert(prefixed.find(key, std::true_type{}) != prefixed.end());
+				assert(prefixed.find(std::string_view{ key }, std::false_type{}) != prefixed.end());
+			}
+
+			assert(prefixed.find(std::string{ "aaaaaaaaaaab" }, std::true_type{}) == prefixed.end());
+			assert(prefixed.erase(std::string{ "aaaaaaaaaaa11" }));
+
+			prefixed.check();
+		}
+
+		printf("--------\n");
+
+		{
+			MerkleAVLTree<int> primary, replica;
+
+			for(int i = 0; i < 1000; ++i){
+				primary.insert(i);
+				replica.insert(999 - i);
+			}
+
+			primary.check();
+			replica.check();
+
+			// same keys, other shape
+			assert(primary.digest() == replica.digest());
+
+			primary.erase(10);
+			primary.insert(5000);
+			replica.erase_range(500, 510);
+
+			assert(primary.digest(0, 500) != replica.digest(0, 500));
+			assert(primary.digest(600, 900) == replica.digest(600, 900));
+
+			std::vector<int> only, missing;
+
+			primary.diff(replica, [&](int const &key, bool const here){
+				(here ? only : missing).push_back(key);
+			});
+
+			assert(only.size() == 11 && only.front() == 500 && only.back() == 5000);
+			assert(missing.size() == 1 && missing.front() == 10);
+
+			for(auto const &key : only)
+				replica.insert(key);
+
+			for(auto const &key : missing)
+				replica.erase(key);
+
+			replica.check();
+			assert(primary.digest() == replica.digest());
+		}
+
+		printf("--------\n");
+
+		{
+			AVLTree<int> hot;
+
+			for(int i = 0; i < 1000; ++i)
+				hot.insert(i);
+
+			hot.set_front_cache(64);
+
+			for(int i = 0; i < 10; ++i)
+				assert(hot.find(7, std::true_type{}) != hot.end());
+
+			auto const stats = hot.front_cache_stats();
+			assert(stats.hits == 9 && stats.misses == 1);
+
+			hot.erase(7);
+			assert(hot.find(7, std::true_type{}) == hot.end());
+
+			hot.relayout();
+			assert(*hot.find(8, std::true_type{}) == 8);
+			assert(*hot.find(8, std::true_type{}) == 8);
+
+			hot.set_front_cache(0);
+			assert(hot.front_cache_stats().hits == 0);
+		}
+
+		printf("--------\n");
+
+		{
+			AVLTree<int> seen;
+
+			seen.set_bloom_filter(10);
+
+			for(int i = 0; i < 5000; i += 2)
+				seen.insert(i);
+
+			for(int i = 0; i < 5000; ++i)
+				assert((seen.find(i, std::true_type{}) != seen.end()) == (i % 2 == 0));
+
+			// erased keys stay in the filter until it is rebuilt.
+			for(int i = 0; i < 5000; i += 4)
+				seen.erase(i);
+
+			for(int i = 0; i < 20000; i += 2)
+				seen.insert(i);
+
+			for(int i = 0; i < 20000; ++i)
+				assert((seen.find(i, std::true_type{}) != seen.end()) == (i % 2 == 0));
+
+			assert(seen.bloom_filter_bytes() > 0);
+
+			seen.set_bloom_filter(0);
+			assert(seen.bloom_filter_bytes() == 0);
+			assert(*seen.find(10, std::true_type{}) == 10);
+		}
+
+		printf("--------\n");
+
+		{
+			AVLSlabMap<int, std::string> map;
+
+			for(int i = 0; i < 100; ++i)
+				map.insert(i, std::to_string(i));
+
+			assert(!map.insert(5, "x").second);
+			assert(*map.find(5) == "5");
+
+			map.insert_or_assign(5, "five");
+			assert(*map.find(5) == "five");
+
+			for(int i = 0; i < 100; i += 3)
+				assert(map.erase(i));
+
+			assert(!map.erase(0));
+			assert(map.find(3) == nullptr);
+
+			// the free slots are reused
+			map[3] = "three";
+			map[1000];
+
+			map.check();
+
+			map.relayout();
+			map.check();
+
+			int prev = -1;
+
+			for(auto const [key, value] : map){
+				assert(prev < key);
+				assert(key == 3 ? value == "three" : key == 1000 ? value.empty() : value == (key == 5 ? "five" : std::to_string(key)));
+				prev = key;
+			}
+
+			assert(map.size() == 100 - 34 + 2);
+		}
+
+		{
+			// a present key is not moved from.
+			AVLSlabMap<std::string, int> names;
+
+			std::string key = "name";
+
+			names.insert(std::string{ key }, 1);
+
+			assert(!names.insert(std::move(key), 2).second);
+			assert(key == "name" && *names.find(key) == 1);
+
+			names[std::move(key)] = 3;
+			assert(key == "name" && *names.find(key) == 3);
+
+			names.check();
+		}
+
+		printf("--------\n");
+
+		{
+			std::vector<int> keys;
+
+			for(int i = -15010; i < 15010; i += 5)
+				keys.push_back(i);
+
+			std::vector<AVLTree<int>::iterator> exact, fix;
+
+			tree.find_many(std::begin(keys), std::end(keys), std::back_inserter(exact), std::true_type{});
+			tree.find_many(std::begin(keys), std::end(keys), std::back_inserter(fix  ), std::false_type{});
+
+			for(size_t i = 0; i < keys.size(); ++i){
+				assert(exact[i] == tree.find(keys[i], std::true_type{}));
+				assert(fix[i]   == tree.find(keys[i], std::false_type{}));
+			}
+
+			{
+				// input iterator, the keys are not kept by the stream.
+				std::stringstream ss;
+
+				for(auto const &key : keys)
+					ss << key << ' ';
+
+				std::vector<AVLTree<int>::iterator> streamed;
+
+				tree.find_many(std::istream_iterator<int>{ ss }, std::istream_iterator<int>{}, std::back_inserter(streamed), std::true_type{});
+
+				assert(streamed == exact);
+			}
+
+			size_t i = 0;
+
+			tree.find_sorted(std::begin(keys), std::end(keys), [&](int const &key, AVLTree<int>::iterator it){
+				assert(key == keys[i]);
+				assert(it  == exact[i]);
+				++i;
+			});
+
+			assert(i == keys.size());
+		}
+
+		printf("--------\n");
+
+		AVLBlockTree<int, 8> blocks;
+
+		for(auto const &x : tree){
+			u = blocks.insert(x) != std::end(blocks);	assert(u);
+			u = blocks.insert(x) == std::end(blocks);	assert(u);
+		}
+
+		blocks.check();
+
+		for(int i = -15010; i < 15010; i += 7){
+			auto const it = tree.find(i, std::false_type{});
+			auto const jt = blocks.find(i, std::false_type{});
+
+			assert((it == std::end(tree)) == (jt == std::end(blocks)));
+			assert(it == std::end(tree) || *it == *jt);
+
+			u = blocks.erase(i) == tree.erase(i); assert(u);
+		}
+
+		blocks.check();
+
+		assert(std::equal(std::begin(tree), std::end(tree), std::begin(blocks), std::end(blocks)));
+
+		{
+			// +inf is greater than the EMPTY slots.
+			AVLBlockTree<double, 8> reals;
+
+			for(int i = 0; i < 5; ++i)
+				reals.insert(double(i));
+
+			reals.insert(std::numeric_limits<double>::infinity());
+			reals.insert(2.5);
+
+			reals.check();
+
+			u = std::is_sorted(std::begin(reals), std::end(reals));	assert(u);
+			u = reals.find(2.5, std::true_type{}) != std::end(reals);	assert(u);
+		}
 	}else{
 		AVLTree<int> tree;
 